@@ -0,0 +1,48 @@
+/**
+ * @brief Link-time plug-ins benchmark: Counting heap allocations
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "linktimeplugin-heap.hpp"
+
+namespace bench {
+    // The heap allocations while counting is on
+    struct Allocations {
+        std::atomic<bool> counting{false};
+        std::atomic<std::size_t> count{0};
+        std::atomic<std::size_t> bytes{0};
+    };
+
+    // Returns the counts, which are there from the first allocation on
+    inline Allocations& allocations() noexcept {
+        static Allocations ret;
+        return ret;
+    }
+}
+
+/**
+ * Replace the global operator new and delete with ones that count the
+ * allocations in bench::allocations(). Use this in one source file of
+ * the benchmark program.
+ */
+#define BENCH_ALLOCATION_HOOKS() \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void* operator new(std::size_t size) { \
+        auto& a = bench::allocations(); \
+        if (a.counting.load(std::memory_order_relaxed)) { \
+            a.count.fetch_add(1, std::memory_order_relaxed); \
+            a.bytes.fetch_add(size, std::memory_order_relaxed); \
+        } \
+        if (const auto p = std::malloc(std::max<std::size_t>(size, 1))) return p; \
+        throw std::bad_alloc(); \
+    } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete(void* p) noexcept { std::free(p); } \
+    static_assert(true, "")
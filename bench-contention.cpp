@@ -0,0 +1,228 @@
+/**
+ * @brief Link-time plug-ins benchmark: Multi-threaded contention
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Enumerates and looks up plug-ins from 1 to N threads at the same
+ * time and reports, for every number of threads, the throughput and
+ * the 50th, 99th, and 99.9th percentile latency, as JSON. Latencies
+ * are measured per batch of operations and divided by the batch size,
+ * because one operation is too short for the clock.
+ *
+ * Besides the registry's own enumeration and lookup, it measures
+ * enumeration into a std::vector per call, which is what callers of
+ * the old plugins() did. It counts heap allocations while the threads
+ * run and flags every operation that allocates, since the threads
+ * then contend in the allocator.
+ *
+ * Usage: bench-contention [ max-threads [ milliseconds ] ]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "bench-allocations.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Number of plug-ins, and operations per latency sample
+    constexpr std::size_t count = 256;
+    constexpr int batch = 16;
+
+    // Plug-in base class and plug-in classes
+    class Handler {
+    public:
+        using Base = Handler;
+        virtual ~Handler() = default;
+        virtual int id() = 0;
+    };
+
+    template<int I>
+    class Plugin : public Handler {
+        int id() override { return I; }
+    };
+
+    // Keys of the plug-ins. The registry refers to them until the end
+    // of the program, and so to the registrars.
+    std::vector<std::string> keys;
+
+    // Registers the plug-ins
+    template<int I>
+    void add(std::size_t n) {
+        for (auto i = I; i < static_cast<int>(n); i += 4) {
+            new linktimeplugin::Registrar<Plugin<I>>(keys[static_cast<std::size_t>(i)].c_str());
+        }
+    }
+
+    // Defeats the optimizer
+    volatile std::uintptr_t sink;
+
+    // The operations. Every call performs one operation; i varies the
+    // key that is looked up.
+    std::uintptr_t enumerate(std::size_t) {
+        std::uintptr_t ret = 0;
+        for (const auto p : linktimeplugin::plugins<Handler>()) {
+            ret += reinterpret_cast<std::uintptr_t>(p);
+        }
+        return ret;
+    }
+
+    std::uintptr_t copy(std::size_t) {
+        const auto plugins = linktimeplugin::plugins<Handler>();
+        const std::vector<Handler*> v(plugins.begin(), plugins.end());
+        std::uintptr_t ret = 0;
+        for (const auto p : v) {
+            ret += reinterpret_cast<std::uintptr_t>(p);
+        }
+        return ret;
+    }
+
+    std::uintptr_t lookup(std::size_t i) {
+        return reinterpret_cast<std::uintptr_t>(
+            linktimeplugin::find<Handler>(keys[i % count]));
+    }
+
+    // Result of one run
+    struct Result {
+        double opsPerSecond;
+        double p50, p99, p999;
+        double allocationsPerOp;
+    };
+
+    // Returns a percentile of sorted samples
+    double percentile(const std::vector<double>& sorted, double p) {
+        const auto i = static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1));
+        return sorted[i];
+    }
+
+    // Runs an operation from some threads at the same time for some
+    // time
+    Result run(std::uintptr_t (*op)(std::size_t), unsigned threads, std::chrono::milliseconds duration) {
+        // Per thread: latency samples (allocated up front, so that they
+        // don't allocate while measuring), and number of operations
+        std::vector<std::vector<double>> samples(threads);
+        for (auto& s : samples) s.reserve(1 << 20);
+        std::vector<std::size_t> ops(threads);
+
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false}, stop{false};
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                auto& s = samples[t];
+                std::uintptr_t sum = 0;
+                std::size_t n = 0;
+                ++ready;
+                while (!go) std::this_thread::yield();
+                while (!stop) {
+                    const auto start = Clock::now();
+                    for (auto i = 0; i < batch; ++i) {
+                        sum += op(n++ * 7 + t);
+                    }
+                    const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+                    if (s.size() < s.capacity()) s.push_back(elapsed.count() / batch);
+                }
+                sink = sum;
+                ops[t] = n;
+            });
+        }
+
+        while (ready < threads) std::this_thread::yield();
+        auto& heap = bench::allocations();
+        heap.count = 0;
+        heap.counting = true;
+        const auto start = Clock::now();
+        go = true;
+        std::this_thread::sleep_for(duration);
+        stop = true;
+        for (auto& w : workers) w.join();
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+        heap.counting = false;
+
+        std::vector<double> all;
+        std::size_t total = 0;
+        for (unsigned t = 0; t < threads; ++t) {
+            all.insert(all.end(), samples[t].begin(), samples[t].end());
+            total += ops[t];
+        }
+        std::sort(all.begin(), all.end());
+
+        Result ret;
+        ret.opsPerSecond = static_cast<double>(total) / elapsed.count();
+        ret.p50 = percentile(all, 0.5);
+        ret.p99 = percentile(all, 0.99);
+        ret.p999 = percentile(all, 0.999);
+        ret.allocationsPerOp = static_cast<double>(heap.count.load()) / static_cast<double>(total);
+        return ret;
+    }
+}
+
+// Count the heap allocations while the threads run
+BENCH_ALLOCATION_HOOKS();
+
+int main(int argc, char** argv) {
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    const auto maxThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : std::max(4u, hardware);
+    const std::chrono::milliseconds duration(argc > 2 ? std::atoi(argv[2]) : 200);
+    if (maxThreads < 1 || duration.count() < 1) {
+        std::cerr << argv[0] << ": Invalid arguments\n";
+        return EXIT_FAILURE;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        keys.push_back("plugin" + std::to_string(i));
+    }
+    add<0>(count);
+    add<1>(count);
+    add<2>(count);
+    add<3>(count);
+
+    // Numbers of threads: powers of two up to the maximum
+    std::vector<unsigned> threads;
+    for (auto t = 1u; t < maxThreads; t *= 2) threads.push_back(t);
+    threads.push_back(maxThreads);
+
+    const struct {
+        const char* name;
+        std::uintptr_t (*op)(std::size_t);
+    } operations[] = {
+        { "enumerate", enumerate },
+        { "enumerate_copy", copy },
+        { "lookup", lookup },
+    };
+
+    std::cout << "{\n  \"plugins\": " << count
+        << ",\n  \"hardware_threads\": " << hardware
+        << ",\n  \"operations\": {\n";
+    for (const auto& o : operations) {
+        std::cout << "    \"" << o.name << "\": [\n";
+        double single = 0;
+        for (const auto t : threads) {
+            const auto r = run(o.op, t, duration);
+            if (t == 1) single = r.opsPerSecond;
+            std::cout << "      {\"threads\": " << t
+                << ", \"ops_per_second\": " << r.opsPerSecond
+                << ", \"scaling\": " << r.opsPerSecond / single / t
+                << ", \"p50_ns\": " << r.p50
+                << ", \"p99_ns\": " << r.p99
+                << ", \"p999_ns\": " << r.p999
+                << ", \"allocations_per_op\": " << r.allocationsPerOp
+                << ", \"allocator_contention\": " << (r.allocationsPerOp >= 0.5 && t > 1 ? "true" : "false")
+                << '}' << (t == threads.back() ? "\n" : ",\n");
+        }
+        std::cout << "    ]" << (&o == std::end(operations) - 1 ? "\n" : ",\n");
+    }
+    std::cout << "  }\n}\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,267 @@
+/**
+ * @brief Link-time plug-ins benchmark: Dispatch mechanisms
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Measures the cost per call of broadcasting a call to 4 to 10,000
+ * registered plug-ins, through
+ *
+ * - the virtual functions of the plug-in base class,
+ * - a table of function pointers and object pointers,
+ * - a std::visit on a vector of std::variant (a closed set of
+ *   plug-in classes, requires C++17), and
+ * - fully static dispatch, where the compiler knows the class of every
+ *   plug-in and can inline the calls,
+ *
+ * with a hot instruction cache (the same calls over and over) and with
+ * a cold one (a megabyte of other code runs before every broadcast).
+ * Writes the results to stdout as JSON.
+ *
+ * Like in bench-enumerate, the plug-in classes repeat, so that the
+ * program compiles in reasonable time. With more than 64 plug-ins, the
+ * code that's called doesn't grow any more, but the data does.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "linktimeplugin.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Numbers of plug-ins to call, number of plug-ins registered, and
+    // number of distinct plug-in classes among them
+    constexpr std::size_t counts[] = { 4, 16, 64, 256, 1024, 4096, 10000 };
+    constexpr int classes = 64;
+    constexpr int groups = (10000 + classes - 1) / classes;
+
+    // Plug-in base class
+    class Handler {
+    public:
+        using Base = Handler;
+        virtual unsigned run(unsigned x) = 0;
+    };
+
+    // The work of plug-in class I: a few arithmetic operations with
+    // constants that differ from class to class, so that every class
+    // has code of its own
+    template<int I, int N = 3>
+    struct Work {
+        static unsigned apply(unsigned x) {
+            return Work<I, N - 1>::apply((x * (2 * (I + N) + 1)) ^ (x >> (N % 5 + 1)));
+        }
+    };
+    template<int I>
+    struct Work<I, 0> {
+        static unsigned apply(unsigned x) { return x + I; }
+    };
+
+    // Plug-in classes. final, so that the calls that know the class
+    // aren't virtual.
+    template<int I>
+    class Plugin final : public Handler {
+    public:
+        unsigned run(unsigned x) override {
+            return Work<I>::apply(x + state_);
+        }
+    private:
+        unsigned state_ = I;
+    };
+
+    // The closed set of plug-in classes for std::variant
+    template<int... I>
+    std::variant<Plugin<I>...> variantOf(std::integer_sequence<int, I...>);
+    using Variant = decltype(variantOf(std::make_integer_sequence<int, classes>()));
+
+    // Entry of the function pointer table
+    struct Entry {
+        void* plugin;
+        unsigned (*run)(void*, unsigned);
+    };
+
+    template<typename PLUGIN>
+    unsigned call(void* plugin, unsigned x) {
+        return static_cast<PLUGIN*>(plugin)->run(x);
+    }
+
+    /*
+     * Registers plug-in classes FIRST to FIRST+N-1 (see bench-enumerate)
+     * and calls them statically. bind() records the plug-in instances
+     * and fills the function pointer table and the variant vector.
+     */
+    template<int FIRST, int N>
+    struct Group {
+        Group<FIRST, N / 2> lower;
+        Group<FIRST + N / 2, N - N / 2> upper;
+
+        void bind(std::vector<Entry>& table, std::vector<Variant>& variants) {
+            lower.bind(table, variants);
+            upper.bind(table, variants);
+        }
+
+        // Calls all plug-ins of the group
+        unsigned run(unsigned x) {
+            return lower.run(x) + upper.run(x);
+        }
+
+        // Calls the first n (1 to N) plug-ins of the group
+        unsigned run(unsigned x, int n) {
+            if (n >= N) return run(x);
+            return n <= N / 2 ? lower.run(x, n) : lower.run(x) + upper.run(x, n - N / 2);
+        }
+    };
+    template<int FIRST>
+    struct Group<FIRST, 1> {
+        linktimeplugin::Registrar<Plugin<FIRST>> registrar;
+        Plugin<FIRST>* plugin = nullptr;
+
+        void bind(std::vector<Entry>& table, std::vector<Variant>& variants) {
+            plugin = static_cast<Plugin<FIRST>*>(registrar.get());
+            table.push_back({ plugin, &call<Plugin<FIRST>> });
+            variants.emplace_back(std::in_place_type<Plugin<FIRST>>, *plugin);
+        }
+        unsigned run(unsigned x) { return plugin->run(x); }
+        unsigned run(unsigned x, int) { return run(x); }
+    };
+
+    Group<0, classes> registrars[groups];
+    std::vector<Entry> table;
+    std::vector<Variant> variants;
+
+    // Defeats the optimizer
+    volatile unsigned sink;
+
+    // Broadcasts a call to the first n plug-ins
+    unsigned virtualCall(std::size_t n, unsigned x) {
+        const auto plugins = linktimeplugin::plugins<Handler>();
+        auto ret = 0u;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret += plugins[i]->run(x);
+        }
+        return ret;
+    }
+
+    unsigned pointerCall(std::size_t n, unsigned x) {
+        auto ret = 0u;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret += table[i].run(table[i].plugin, x);
+        }
+        return ret;
+    }
+
+    unsigned variantCall(std::size_t n, unsigned x) {
+        auto ret = 0u;
+        for (std::size_t i = 0; i < n; ++i) {
+            ret += std::visit([x](auto& plugin) { return plugin.run(x); }, variants[i]);
+        }
+        return ret;
+    }
+
+    unsigned staticCall(std::size_t n, unsigned x) {
+        auto ret = 0u;
+        const auto full = n / classes;
+        for (std::size_t g = 0; g < full; ++g) {
+            ret += registrars[g].run(x);
+        }
+        if (n % classes) {
+            ret += registrars[full].run(x, static_cast<int>(n % classes));
+        }
+        return ret;
+    }
+
+    // Runs a megabyte of code (on x86, four on most others) to evict
+    // the plug-ins' code from the instruction caches
+    __attribute__((noinline)) void evict() {
+        asm volatile(".rept 1048576\n\tnop\n\t.endr");
+    }
+
+    // Returns the best time per call in nanoseconds, calling the first
+    // n plug-ins over and over
+    template<typename F>
+    double hot(F f, std::size_t n) {
+        const auto passes = std::max<std::size_t>(1, 100000 / n);
+        auto best = 1e100;
+        for (auto r = 0; r < 10; ++r) {
+            auto sum = 0u;
+            const auto start = Clock::now();
+            for (std::size_t p = 0; p < passes; ++p) {
+                sum += f(n, static_cast<unsigned>(p));
+            }
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            sink = sum;
+            best = std::min(best, elapsed.count() / static_cast<double>(passes * n));
+        }
+        return best;
+    }
+
+    // Returns the median time per call in nanoseconds, calling the
+    // first n plug-ins once after evicting them from the instruction
+    // caches, minus the overhead of reading the clock
+    template<typename F>
+    double cold(F f, std::size_t n, double overhead) {
+        std::vector<double> times;
+        for (auto r = 0; r < 101; ++r) {
+            evict();
+            const auto start = Clock::now();
+            sink = f(n, static_cast<unsigned>(r));
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            times.push_back(elapsed.count());
+        }
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        return std::max(0.0, times[times.size() / 2] - overhead) / static_cast<double>(n);
+    }
+
+    // Returns the median time of reading the clock twice
+    double clockOverhead() {
+        std::vector<double> times;
+        for (auto r = 0; r < 101; ++r) {
+            const auto start = Clock::now();
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            times.push_back(elapsed.count());
+        }
+        std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+        return times[times.size() / 2];
+    }
+
+    // Writes a JSON object member with hot and cold times per call
+    template<typename F>
+    void member(const char* name, F f, std::size_t n, double overhead, bool last = false) {
+        std::cout << "      \"" << name << "\": {\"hot_ns\": " << hot(f, n)
+            << ", \"cold_ns\": " << cold(f, n, overhead) << '}'
+            << (last ? "\n" : ",\n");
+    }
+}
+
+int main() {
+    table.reserve(groups * classes);
+    variants.reserve(groups * classes);
+    for (auto& g : registrars) {
+        g.bind(table, variants);
+    }
+    if (linktimeplugin::plugins<Handler>().size() != table.size()) {
+        std::cerr << "Unexpected number of plug-ins\n";
+        return EXIT_FAILURE;
+    }
+    const auto overhead = clockOverhead();
+
+    std::cout << "{\n  \"clock_overhead_ns\": " << overhead << ",\n  \"plugins\": [\n";
+    for (const auto n : counts) {
+        std::cout << "    {\n      \"count\": " << n << ",\n";
+        member("virtual", virtualCall, n, overhead);
+        member("function_pointer", pointerCall, n, overhead);
+        member("variant", variantCall, n, overhead);
+        member("static", staticCall, n, overhead, true);
+        std::cout << "    }" << (n == counts[std::size(counts) - 1] ? "\n" : ",\n");
+    }
+    std::cout << "  ]\n}\n";
+
+    return EXIT_SUCCESS;
+}
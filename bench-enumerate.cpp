@@ -0,0 +1,160 @@
+/**
+ * @brief Link-time plug-ins benchmark: Plug-in enumeration
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Measures the cost per plug-in of enumerating thousands of plug-ins,
+ * comparing the registry as it used to be (a virtual call per
+ * registrar into a freshly allocated vector on every enumeration)
+ * with the current one (a plain view of recorded pointers, and the
+ * registrars with the pointer that each of them recorded).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "linktimeplugin.hpp"
+
+namespace {
+    // Number of plug-ins, and number of distinct plug-in classes
+    // among them (the classes repeat, so that the targets of indirect
+    // calls vary like in a real program without compiling thousands
+    // of classes)
+    constexpr int count = 4096;
+    constexpr int classes = 64;
+
+    // Plug-in base class and plug-in classes
+    class Handler {
+    public:
+        using Base = Handler;
+        virtual int id() = 0;
+    };
+
+    template<int I>
+    class Plugin : public Handler {
+        int id() override { return I; }
+    };
+
+    /*
+     * The registrar as it was before the instance pointer was recorded
+     * at registration: one virtual call per registrar and enumeration.
+     */
+    class VirtualRegistrar {
+    public:
+        VirtualRegistrar() {
+            registrars().push_back(this);
+        }
+        virtual ~VirtualRegistrar() = default;
+        virtual Handler& operator()() = 0;
+
+        static std::vector<VirtualRegistrar*>& registrars() {
+            static std::vector<VirtualRegistrar*> ret;
+            return ret;
+        }
+
+        // The old plugins(): a new vector on every call
+        static std::vector<Handler*> plugins() {
+            std::vector<Handler*> ret;
+            for (const auto r : registrars()) {
+                ret.push_back(&(*r)());
+            }
+            return ret;
+        }
+    };
+
+    template<typename PLUGIN>
+    class OldRegistrar : public VirtualRegistrar {
+        PLUGIN plugin_;
+        Handler& operator()() override { return plugin_; }
+    };
+
+    // Registers plug-in classes FIRST to FIRST+N-1 with both registrars.
+    // Splits the range in halves to keep the template recursion flat.
+    template<int FIRST, int N>
+    struct Registrars {
+        Registrars<FIRST, N / 2> lower;
+        Registrars<FIRST + N / 2, N - N / 2> upper;
+    };
+    template<int FIRST>
+    struct Registrars<FIRST, 1> {
+        OldRegistrar<Plugin<FIRST>> before;
+        linktimeplugin::Registrar<Plugin<FIRST>> after;
+    };
+
+    // Defeats the optimizer
+    volatile std::uintptr_t sink;
+
+    // Runs an enumeration function repeatedly and returns the best
+    // time per plug-in in nanoseconds.
+    template<typename F>
+    double measure(F f) {
+        constexpr auto rounds = 200;
+        auto best = 1e100;
+        for (auto r = 0; r < 10; ++r) {
+            const auto start = std::chrono::steady_clock::now();
+            for (auto i = 0; i < rounds; ++i) {
+                f();
+            }
+            const std::chrono::duration<double, std::nano> elapsed =
+                std::chrono::steady_clock::now() - start;
+            best = std::min(best, elapsed.count() / rounds / count);
+        }
+        return best;
+    }
+}
+
+static Registrars<0, classes> registrars[count / classes];
+
+int main() {
+    // Before: new vector and a virtual call per plug-in
+    const auto before = measure([] {
+        std::uintptr_t sum = 0;
+        for (const auto p : VirtualRegistrar::plugins()) {
+            sum += reinterpret_cast<std::uintptr_t>(p);
+        }
+        sink = sum;
+    });
+
+    // Before, without the vector: the virtual calls alone
+    const auto calls = measure([] {
+        std::uintptr_t sum = 0;
+        for (const auto r : VirtualRegistrar::registrars()) {
+            sum += reinterpret_cast<std::uintptr_t>(&(*r)());
+        }
+        sink = sum;
+    });
+
+    // After: a view of the recorded pointers
+    const auto after = measure([] {
+        std::uintptr_t sum = 0;
+        for (const auto p : linktimeplugin::plugins<Handler>()) {
+            sum += reinterpret_cast<std::uintptr_t>(p);
+        }
+        sink = sum;
+    });
+
+    // After, through the registrars: the recorded pointer of every
+    // registrar (a plain load instead of a virtual call)
+    const auto loads = measure([] {
+        std::uintptr_t sum = 0;
+        for (const auto r : linktimeplugin::RegistrarBase<Handler>::registrars()) {
+            sum += reinterpret_cast<std::uintptr_t>(r->get());
+        }
+        sink = sum;
+    });
+
+    std::cout << "Enumerating " << count << " plug-ins, nanoseconds per plug-in:\n"
+        << std::fixed << std::setprecision(3)
+        << "  vector + virtual call (before) " << std::setw(8) << before << '\n'
+        << "  virtual call only              " << std::setw(8) << calls << '\n'
+        << "  recorded pointers (after)      " << std::setw(8) << after << '\n'
+        << "  registrars + get() (after)     " << std::setw(8) << loads << '\n';
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+/**
+ * @brief Link-time plug-ins benchmark: Registry scaling
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Driver for BENCH_PLUGINS synthetic plug-ins, each in a translation
+ * unit of its own (generated at configure time, see CMakeLists.txt).
+ * Measures registration, enumeration, calls, and lookup, and writes the
+ * results to stdout as JSON. Built twice: With the plug-ins in their
+ * registrars, and with the plug-ins in an arena (BENCH_ARENA).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench-scaling.hpp"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Number of synthetic plug-ins
+    constexpr std::size_t count = BENCH_PLUGINS;
+
+    // Defeats the optimizer
+    volatile std::uintptr_t sink;
+
+    // Returns the nanoseconds since start
+    double since(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // Runs a function repeatedly and returns the best time of one
+    // round in nanoseconds
+    template<typename F>
+    double best(int rounds, F f) {
+        auto ret = 1e100;
+        for (auto r = 0; r < rounds; ++r) {
+            const auto start = Clock::now();
+            f();
+            ret = std::min(ret, since(start));
+        }
+        return ret;
+    }
+
+    // Returns the time of one enumeration of all plug-ins
+    double enumerate() {
+        return best(100, [] {
+            std::uintptr_t sum = 0;
+            for (const auto p : linktimeplugin::plugins<Synthetic>()) {
+                sum += reinterpret_cast<std::uintptr_t>(p);
+            }
+            sink = sum;
+        });
+    }
+
+    // Returns the time of one call of every plug-in, which touches
+    // every plug-in object
+    double call() {
+        return best(100, [] {
+            std::uintptr_t sum = 0;
+            for (const auto p : linktimeplugin::plugins<Synthetic>()) {
+                sum += p->id();
+            }
+            sink = sum;
+        });
+    }
+
+    // Returns the time of looking up all the given keys
+    double lookup(const std::vector<std::string>& keys) {
+        return best(10, [&] {
+            std::uintptr_t sum = 0;
+            for (const auto& key : keys) {
+                sum += reinterpret_cast<std::uintptr_t>(linktimeplugin::find<Synthetic>(key));
+            }
+            sink = sum;
+        });
+    }
+
+    // Plug-ins that are registered at run-time to measure the cost of
+    // registration, in a registry of their own (the synthetic plug-ins'
+    // registry is frozen by then)
+    class Probe {
+    public:
+        using Base = Probe;
+        virtual ~Probe() = default;
+    };
+    class ProbePlugin : public Probe {};
+
+    // Returns the time of registering count keyed plug-ins at run
+    // time: Constructing their registrars, each of which adds its
+    // plug-in to the registry and publishes a new snapshot. Destroying
+    // them afterwards (which unregisters them) isn't timed.
+    double registration(const std::vector<std::string>& keys) {
+        std::vector<std::unique_ptr<linktimeplugin::Registrar<ProbePlugin>>> registrars;
+        registrars.reserve(keys.size());
+        const auto start = Clock::now();
+        for (const auto& key : keys) {
+            registrars.emplace_back(new linktimeplugin::Registrar<ProbePlugin>(key.c_str()));
+        }
+        return since(start);
+    }
+
+    // Writes a JSON object member with per-operation times
+    void member(const char* name, double total, std::size_t n, bool last = false) {
+        std::cout << "    \"" << name << "\": {\"ns_total\": " << total
+            << ", \"ns_per_plugin\": " << (n ? total / n : 0) << '}'
+            << (last ? "\n" : ",\n");
+    }
+}
+
+int main() {
+    // Keys of the plug-ins in random order, and keys that don't exist
+    std::vector<std::string> hits, misses, probes;
+    for (std::size_t i = 0; i < count; ++i) {
+        hits.push_back("plugin" + std::to_string(i));
+        misses.push_back("missing" + std::to_string(i));
+        probes.push_back("probe" + std::to_string(i));
+    }
+    std::shuffle(hits.begin(), hits.end(), std::mt19937(42));
+
+    // The first enumeration lists the plug-ins of the snapshot that the
+    // registrations published, constructing the lazy (arena) ones
+    const auto start = Clock::now();
+    const auto found = linktimeplugin::plugins<Synthetic>().size();
+    const auto snapshot = since(start);
+
+    const auto enumeration = enumerate();
+    const auto calls = call();
+    const auto hit = lookup(hits);
+    const auto miss = lookup(misses);
+
+    const auto frozen = best(1, [] { linktimeplugin::freeze<Synthetic>(); });
+    const auto frozenEnumeration = enumerate();
+    const auto frozenHit = lookup(hits);
+    const auto frozenMiss = lookup(misses);
+
+    const auto registered = registration(probes);
+
+    std::cout << "{\n"
+        << "  \"plugins\": " << count << ",\n"
+        << "  \"registered\": " << found << ",\n"
+#ifdef BENCH_ARENA
+        << "  \"arena\": true,\n"
+#else
+        << "  \"arena\": false,\n"
+#endif
+        << "  \"registration\": {\n";
+    member("register", registered, count);
+    member("snapshot", snapshot, count);
+    member("freeze", frozen, count, true);
+    std::cout << "  },\n"
+        << "  \"enumeration\": {\n";
+    member("snapshot", enumeration, count);
+    member("call", calls, count);
+    member("frozen", frozenEnumeration, count, true);
+    std::cout << "  },\n"
+        << "  \"lookup\": {\n";
+    member("hit", hit, count);
+    member("miss", miss, count);
+    member("frozen_hit", frozenHit, count);
+    member("frozen_miss", frozenMiss, count, true);
+    std::cout << "  }\n"
+        << "}\n";
+
+    return found == count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,23 @@
+/**
+ * @brief Link-time plug-ins benchmark: Registry scaling
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <cstddef>
+#include "linktimeplugin.hpp"
+#ifdef BENCH_ARENA
+#include "linktimeplugin-arena.hpp"
+#endif
+
+// Base class of the synthetic plug-ins, which are generated from
+// bench-scaling-plugin.cpp.in at configure time (and registered with
+// REGISTER_ARENA_PLUGIN if BENCH_ARENA is defined)
+class Synthetic {
+public:
+    using Base = Synthetic;
+    virtual std::size_t id() = 0;
+};
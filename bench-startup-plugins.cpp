@@ -0,0 +1,117 @@
+/**
+ * @brief Link-time plug-ins benchmark: Startup cost of static registration
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * A program with BENCH_PLUGINS plug-ins of BENCH_PLUGIN_SIZE bytes
+ * each, registered eagerly (or lazily if BENCH_LAZY is defined). It
+ * records when static initialization starts and how much heap it
+ * allocates, and writes its measurements as one line of JSON when
+ * main is reached. Run by bench-startup, which measures the time
+ * from exec to main.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include "linktimeplugin.hpp"
+#include "bench-allocations.hpp"
+
+namespace {
+    // Returns CLOCK_MONOTONIC in nanoseconds, which is the same in
+    // all processes
+    std::int64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return std::int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    // When static initialization started
+    std::int64_t started = 0;
+
+    // Runs before all static objects with default priority, i. e.
+    // before the registrars
+    __attribute__((constructor(101))) void start() {
+        started = now();
+        bench::allocations().counting = true;
+    }
+
+    // Plug-in base class and plug-in classes. Every plug-in fills its
+    // data in its ctor, like a plug-in that sets up tables would.
+    class Handler {
+    public:
+        using Base = Handler;
+        virtual int id() = 0;
+    };
+
+    template<int I>
+    class Plugin : public Handler {
+    public:
+        Plugin() {
+            std::memset(data_, I, sizeof(data_));
+        }
+        int id() override { return data_[0]; }
+    private:
+        char data_[BENCH_PLUGIN_SIZE];
+    };
+
+#ifdef BENCH_LAZY
+    template<typename PLUGIN>
+    using Registrar = linktimeplugin::LazyRegistrar<PLUGIN>;
+#else
+    template<typename PLUGIN>
+    using Registrar = linktimeplugin::Registrar<PLUGIN>;
+#endif
+
+    // Registers plug-in classes FIRST to FIRST+N-1 (see bench-enumerate)
+    template<int FIRST, int N>
+    struct Registrars {
+        Registrars<FIRST, N / 2> lower;
+        Registrars<FIRST + N / 2, N - N / 2> upper;
+    };
+    template<int FIRST>
+    struct Registrars<FIRST, 1> {
+        Registrar<Plugin<FIRST>> registrar;
+    };
+
+    // 64 plug-in classes, repeated
+    constexpr int classes = BENCH_PLUGINS < 64 ? BENCH_PLUGINS : 64;
+    Registrars<0, classes> registrars[BENCH_PLUGINS / classes];
+
+    // Returns the resident set size in bytes
+    std::size_t rss() {
+        long pages = 0, resident = 0;
+        if (const auto f = std::fopen("/proc/self/statm", "r")) {
+            if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+            std::fclose(f);
+        }
+        return static_cast<std::size_t>(resident) * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+}
+
+// Count the heap allocations during static initialization
+BENCH_ALLOCATION_HOOKS();
+
+int main() {
+    const auto reached = now();
+    auto& heap = bench::allocations();
+    heap.counting = false;
+
+    std::printf("{\"mode\": \"%s\", \"plugins\": %d, \"plugin_size\": %d, "
+        "\"static_init_start_ns\": %lld, \"main_ns\": %lld, "
+        "\"rss_bytes\": %zu, \"heap_bytes\": %zu, \"heap_allocations\": %zu}\n",
+#ifdef BENCH_LAZY
+        "lazy",
+#else
+        "eager",
+#endif
+        BENCH_PLUGINS / classes * classes, BENCH_PLUGIN_SIZE,
+        static_cast<long long>(started), static_cast<long long>(reached),
+        rss(), heap.bytes.load(), heap.count.load());
+
+    return EXIT_SUCCESS;
+}
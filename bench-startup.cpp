@@ -0,0 +1,137 @@
+/**
+ * @brief Link-time plug-ins benchmark: Startup time and memory footprint
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Starts every variant of bench-startup-plugins (built with different
+ * numbers and sizes of plug-ins) several times and reports, as JSON,
+ * the median time from exec to main, the median time spent in static
+ * initialization, the resident set size at main, and the heap
+ * allocated during static initialization.
+ *
+ * Usage: bench-startup [ runs [ program ... ] ]
+ * Without programs, runs the variants that were built along with it.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "bench-startup-variants.hpp"
+
+namespace {
+    // Returns CLOCK_MONOTONIC in nanoseconds
+    std::int64_t now() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return std::int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    // Starts a program and returns the time it was started and the
+    // line it wrote to stdout
+    std::string start(const std::string& program, std::int64_t& started) {
+        int fd[2];
+        if (pipe(fd) != 0) {
+            throw std::runtime_error("pipe failed");
+        }
+
+        started = now();
+        const auto pid = fork();
+        if (pid < 0) {
+            throw std::runtime_error("fork failed");
+        }
+        if (pid == 0) {
+            dup2(fd[1], STDOUT_FILENO);
+            close(fd[0]);
+            close(fd[1]);
+            execl(program.c_str(), program.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+
+        close(fd[1]);
+        std::string ret;
+        char buffer[512];
+        for (ssize_t n; (n = read(fd[0], buffer, sizeof(buffer))) > 0;) {
+            ret.append(buffer, static_cast<std::size_t>(n));
+        }
+        close(fd[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("Cannot run " + program);
+        }
+        return ret;
+    }
+
+    // Returns a numeric member of a flat JSON object
+    long long number(const std::string& json, const std::string& name) {
+        std::smatch m;
+        if (!std::regex_search(json, m, std::regex("\"" + name + "\": (-?[0-9]+)"))) {
+            throw std::runtime_error("No " + name + " in " + json);
+        }
+        return std::stoll(m[1]);
+    }
+
+    // Returns a string member of a flat JSON object
+    std::string text(const std::string& json, const std::string& name) {
+        std::smatch m;
+        if (!std::regex_search(json, m, std::regex("\"" + name + "\": \"([^\"]*)\""))) {
+            throw std::runtime_error("No " + name + " in " + json);
+        }
+        return m[1];
+    }
+
+    // Returns the median of some values
+    long long median(std::vector<long long> v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+}
+
+int main(int argc, char** argv) try {
+    const auto runs = argc > 1 ? std::atoi(argv[1]) : 20;
+    std::vector<std::string> programs(argv + std::min(argc, 2), argv + argc);
+    if (programs.empty()) {
+        programs.assign(std::begin(variants), std::end(variants));
+    }
+    if (runs < 1) {
+        throw std::runtime_error("Invalid number of runs");
+    }
+
+    std::cout << "{\n  \"runs\": " << runs << ",\n  \"variants\": [\n";
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        std::vector<long long> toMain, staticInit;
+        std::string line;
+        for (auto r = 0; r < runs; ++r) {
+            std::int64_t started;
+            line = start(programs[i], started);
+            toMain.push_back(number(line, "main_ns") - started);
+            staticInit.push_back(number(line, "main_ns") - number(line, "static_init_start_ns"));
+        }
+
+        std::cout << "    {\"mode\": \"" << text(line, "mode") << '"'
+            << ", \"plugins\": " << number(line, "plugins")
+            << ", \"plugin_size\": " << number(line, "plugin_size")
+            << ", \"time_to_main_ns\": " << median(toMain)
+            << ", \"static_init_ns\": " << median(staticInit)
+            << ", \"rss_bytes\": " << number(line, "rss_bytes")
+            << ", \"heap_bytes\": " << number(line, "heap_bytes")
+            << ", \"heap_allocations\": " << number(line, "heap_allocations")
+            << '}' << (i + 1 < programs.size() ? ",\n" : "\n");
+    }
+    std::cout << "  ]\n}\n";
+
+    return EXIT_SUCCESS;
+} catch(const std::exception& e) {
+    std::cerr << argv[0] << ": " << e.what() << '\n';
+    return EXIT_FAILURE;
+}
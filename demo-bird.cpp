@@ -18,5 +18,6 @@ namespace {
         }
     };
 
-    REGISTER_PLUGIN(Bird);
+    // Constructed on first use only
+    REGISTER_LAZY_PLUGIN(Bird, "bird", linktimeplugin::meta("Bird", 1, 0, Animal::flies));
 }
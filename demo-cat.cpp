@@ -18,5 +18,5 @@ namespace {
         }
     };
 
-    REGISTER_PLUGIN(Cat);
+    REGISTER_PLUGIN(Cat, "cat", linktimeplugin::meta("Cat", 1, 0, Animal::pet));
 }
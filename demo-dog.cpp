@@ -18,5 +18,5 @@ namespace {
         }
     };
 
-    REGISTER_PLUGIN(Dog);
+    REGISTER_PLUGIN(Dog, "dog", linktimeplugin::meta("Dog", 1, 0, Animal::pet));
 }
@@ -7,8 +7,38 @@
 
 #include <iostream>
 #include "demo.hpp"
+#include "linktimeplugin-heap.hpp"
 
-int main() {
+// Book the heap use of the animals if LINKTIMEPLUGIN_HEAP is defined
+LINKTIMEPLUGIN_HEAP_HOOKS();
+
+int main(int argc, char** argv) {
+    // With arguments, look up the animals by key
+    if (argc > 1) {
+        auto found = true;
+        for (auto i = 1; i < argc; ++i) {
+            if (const auto animal = linktimeplugin::find<Animal>(argv[i])) {
+                std::cout << animal->name() << ": " << animal->sound() << '\n';
+            } else {
+                std::cerr << argv[i] << ": No such animal\n";
+                found = false;
+            }
+        }
+
+        // List the animals by their metadata, without constructing them
+        if (!found) {
+            std::cerr << "Known animals:";
+            for (const auto r : linktimeplugin::RegistrarBase<Animal>::registrars()) {
+                if (!r->key()) continue;
+                std::cerr << ' ' << r->key() << " (";
+                std::cerr.write(r->meta().name, r->meta().length) << ')';
+            }
+            std::cerr << '\n';
+        }
+        return EXIT_SUCCESS;
+    }
+
+    // Without arguments, show all animals
     for (const auto animal : linktimeplugin::plugins<Animal>()) {
         std::cout << animal->name() << ": " << animal->sound() << '\n';
     }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include "linktimeplugin.hpp"
 
@@ -16,6 +17,10 @@ public:
     // Make the class known to the registrar
     using Base = Animal;
 
+    // Capabilities of the animals, for their metadata
+    static constexpr std::uint64_t pet = 1;
+    static constexpr std::uint64_t flies = 2;
+
     // Define the functions that are to be implemented by
     // the plug-ins. Must be pure virtual and public.
     // Can have any name and signature.
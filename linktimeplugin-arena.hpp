@@ -0,0 +1,230 @@
+/**
+ * @brief Link-time plug-in management: Arena placement
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#if defined(LINKTIMEPLUGIN_HUGE_PAGES) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+#include "linktimeplugin.hpp"
+
+/**
+ * Arena placement of link-time plug-ins.
+ *
+ * A plug-in registered with REGISTER_PLUGIN lives in its registrar,
+ * which is a static object somewhere in the data section of the
+ * translation unit that registered it, so iterating the plug-ins
+ * touches one cache line (or page) per plug-in. A plug-in registered
+ * with REGISTER_ARENA_PLUGIN instead lives in an arena: One memory
+ * block per plug-in base class, aligned to a cache line, that holds
+ * the plug-ins one after another in the order of registration (which
+ * is the order of linktimeplugin::plugins()).
+ *
+ * Arena plug-ins are constructed on first use, like lazy plug-ins. The
+ * first construction allocates the arena for all arena plug-ins that
+ * are registered by then (usually all of them, since that happens
+ * during static initialization); plug-ins registered later get another
+ * arena. The arenas are never freed.
+ *
+ * With linktimeplugin::padded(), a plug-in starts on a cache line of
+ * its own and its size is rounded up to whole cache lines, so plug-ins
+ * that write hot counters don't slow each other down by false sharing.
+ *
+ * If LINKTIMEPLUGIN_HUGE_PAGES is defined (Linux only), the arenas are
+ * mapped on huge pages if the system has some reserved, and marked for
+ * transparent huge pages otherwise.
+ *
+ * Example:
+ *
+ *      REGISTER_ARENA_PLUGIN(Plugin, "plugin");
+ *      REGISTER_ARENA_PLUGIN(Counter, "counter", linktimeplugin::padded());
+ */
+namespace linktimeplugin {
+    /*
+     * The arenas of one plug-in base class. A registrar reserves a
+     * place when it's constructed; the place gets an address once the
+     * first arena plug-in is constructed.
+     */
+    template<typename BASE>
+    class Arena {
+    public:
+        // Size of a cache line
+        static constexpr std::size_t line = 64;
+
+        // Reserves a place of the given size and alignment. Returns its
+        // number, or npos if there's not enough memory.
+        static std::size_t reserve(std::size_t size, std::size_t align) noexcept {
+            try {
+                std::lock_guard<std::mutex> lock(mutex());
+                places().push_back(Place{size, align, nullptr});
+                return places().size() - 1;
+            } catch(...) {
+                return npos;
+            }
+        }
+
+        // Returns the address of a place, allocating an arena for all
+        // places that don't have an address yet if necessary. Returns
+        // nullptr if there's not enough memory.
+        static void* address(std::size_t place) noexcept {
+            if (place == npos) return nullptr;
+            std::lock_guard<std::mutex> lock(mutex());
+            auto& all = places();
+            if (!all[place].address) {
+                // Lay out the places that don't have an address yet
+                std::size_t size = 0, align = line;
+                for (const auto& p : all) {
+                    if (p.address) continue;
+                    size = (size + p.align - 1) / p.align * p.align + p.size;
+                    if (p.align > align) align = p.align;
+                }
+                const auto block = allocate(size, align);
+                if (!block) return nullptr;
+
+                std::size_t offset = 0;
+                for (auto& p : all) {
+                    if (p.address) continue;
+                    offset = (offset + p.align - 1) / p.align * p.align;
+                    p.address = block + offset;
+                    offset += p.size;
+                }
+            }
+            return all[place].address;
+        }
+
+        static constexpr std::size_t npos = std::size_t(-1);
+
+    private:
+        struct Place {
+            std::size_t size;
+            std::size_t align;
+            unsigned char* address;
+        };
+
+        // The places of all arena plug-ins, in order of registration,
+        // and the mutex that protects them. Never freed, like the
+        // arenas.
+        static std::vector<Place>& places() noexcept {
+            static const auto ret = new std::vector<Place>;
+            return *ret;
+        }
+        static std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // Allocates an arena (aligned to a cache line, or to align if
+        // that's more), or returns nullptr if there's not enough memory
+        static unsigned char* allocate(std::size_t size, std::size_t align) noexcept {
+#if defined(LINKTIMEPLUGIN_HUGE_PAGES) && defined(__linux__)
+            // Reserved huge pages, or else transparent ones (which need
+            // a block that's aligned to a huge page, which is more than
+            // any plug-in class asks for)
+            (void)align;
+            const std::size_t huge = std::size_t(2) << 20;
+            const auto length = (size + huge - 1) / huge * huge;
+            auto p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) return static_cast<unsigned char*>(p);
+            p = mmap(nullptr, length + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return nullptr;
+            const auto aligned = (reinterpret_cast<std::uintptr_t>(p) + huge - 1) / huge * huge;
+            madvise(reinterpret_cast<void*>(aligned), length, MADV_HUGEPAGE);
+            return reinterpret_cast<unsigned char*>(aligned);
+#else
+            const auto p = static_cast<unsigned char*>(::operator new(size + align, std::nothrow));
+            if (!p) return nullptr;
+            return p + (align - reinterpret_cast<std::uintptr_t>(p) % align) % align;
+#endif
+        }
+    };
+
+    /*
+     * The size and alignment of a plug-in's place in the arena: The
+     * plug-in object, rounded up to whole cache lines if it's padded.
+     * This is what the plug-in's budget applies to. (The gap that
+     * aligning the place may leave after the previous plug-in depends
+     * on the order of registration, so it isn't part of it.)
+     */
+    template<typename PLUGIN, bool PADDED>
+    struct ArenaPlace {
+        static constexpr std::size_t line = Arena<typename PLUGIN::Base>::line;
+        static constexpr std::size_t size = PADDED ? (sizeof(PLUGIN) + line - 1) / line * line : sizeof(PLUGIN);
+        static constexpr std::size_t align = PADDED && alignof(PLUGIN) < line ? line : alignof(PLUGIN);
+    };
+
+    /*
+     * Derived registrar class for plug-ins that live in the arena of
+     * their plug-in base class. The plug-in is constructed on first
+     * use, like with LazyRegistrar.
+     * PLUGIN is the plug-in class (derived from the plug-in base class).
+     */
+    template<typename PLUGIN>
+    class ArenaRegistrar : public RegistrarBase<typename PLUGIN::Base> {
+        using Base = typename PLUGIN::Base;
+
+    public:
+        // Ctor. The options are passed on to the registrar base class.
+        template<typename... OPTIONS>
+        explicit ArenaRegistrar(OPTIONS&&... options) noexcept
+        : RegistrarBase<Base>(std::forward<OPTIONS>(options)...) {
+            using Place = ArenaPlace<PLUGIN, Has<Padded, typename std::decay<OPTIONS>::type...>::value>;
+            static_assert(Place::size <= Limit<typename std::decay<OPTIONS>::type...>::value,
+                "The plug-in class exceeds its budget");
+            place_ = Arena<Base>::reserve(Place::size, Place::align);
+            this->template add<PLUGIN, &make>(nullptr);
+        }
+
+        ~ArenaRegistrar() {
+            this->remove();
+            if (const auto p = instance_.load()) p->~PLUGIN();
+        }
+
+    private:
+        std::size_t place_;
+        std::mutex mutex_;
+        std::atomic<PLUGIN*> instance_{nullptr};
+
+        // Constructs the plug-in in the arena exactly once, like
+        // LazyRegistrar. If there's no arena or the plug-in's ctor
+        // throws, the instance stays unset and the next call tries again.
+        static Base* make(RegistrarBase<Base>& registrar) {
+            auto& self = static_cast<ArenaRegistrar&>(registrar);
+            if (const auto p = self.instance_.load(std::memory_order_acquire)) {
+                return p;
+            }
+            std::lock_guard<std::mutex> lock(self.mutex_);
+            if (const auto p = self.instance_.load(std::memory_order_relaxed)) {
+                return p;
+            }
+            const auto storage = Arena<Base>::address(self.place_);
+            if (!storage) throw std::bad_alloc();
+            const auto ret = self.template construct<PLUGIN>(storage);
+            self.instance_.store(ret, std::memory_order_release);
+            return ret;
+        }
+    };
+}
+
+/**
+ * Register one plug-in class whose instance lives in the arena of its
+ * plug-in base class and is constructed on first use. Takes the same
+ * arguments as REGISTER_PLUGIN, plus linktimeplugin::padded().
+ *
+ * Example:
+ *
+ *      REGISTER_ARENA_PLUGIN(Plugin, "plugin");
+ */
+#define REGISTER_ARENA_PLUGIN(...) LINKTIMEPLUGIN_REGISTER(ArenaRegistrar, __VA_ARGS__)
@@ -0,0 +1,281 @@
+/**
+ * @brief Link-time plug-in management: Epoch-based reclamation
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+/**
+ * Epoch-based reclamation of the registry's snapshots.
+ *
+ * The registry publishes its contents as immutable snapshots. When a
+ * plug-in is registered or unregistered, the registry publishes a new
+ * snapshot and retires the old one, which is freed once no thread can
+ * still read it. A thread that reads a snapshot pins the current epoch
+ * (with a linktimeplugin::Pin) while it does so; pinning is a few
+ * loads and stores on a slot of the thread's own, without locks or
+ * loops, so readers are wait-free. Retired snapshots are freed as soon
+ * as all threads that were pinned when they were retired are unpinned.
+ */
+namespace linktimeplugin {
+    namespace epoch {
+        // The current epoch. Starts at 1; 0 means "not pinned".
+        inline std::atomic<std::uint64_t>& global() noexcept {
+            static std::atomic<std::uint64_t> ret{1};
+            return ret;
+        }
+
+        /*
+         * The epoch that one thread is pinned at (0: none), on a cache
+         * line of its own. Only the owning thread writes it.
+         */
+        struct alignas(64) Reader {
+            std::atomic<std::uint64_t> pinned{0};
+        };
+
+        /*
+         * A retired object, and the epoch it was retired in
+         */
+        struct Retired {
+            void* object;
+            void (*destroy)(void*);
+            std::uint64_t epoch;
+        };
+
+        // The readers of all threads, the readers that no thread uses,
+        // the retired objects, and the mutex that protects them. They're never freed, so that
+        // threads can read and retire until the program ends.
+        inline std::vector<Reader*>& readers() noexcept {
+            static const auto ret = new std::vector<Reader*>;
+            return *ret;
+        }
+        inline std::vector<Retired>& retired() noexcept {
+            static const auto ret = new std::vector<Retired>;
+            return *ret;
+        }
+        inline std::vector<Reader*>& spares() noexcept {
+            static const auto ret = new std::vector<Reader*>;
+            return *ret;
+        }
+        inline std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // Returns the calling thread's reader, or nullptr if it has none
+        inline Reader*& own() noexcept {
+            static thread_local Reader* ret = nullptr;
+            return ret;
+        }
+
+        /*
+         * The reader of one thread. It's registered on the thread's
+         * first pin and unregistered when the thread ends, so the list
+         * of readers holds only the threads that are alive.
+         */
+        struct Registration {
+            Reader reader;
+            bool registered = false;
+
+            ~Registration() {
+                closed() = true;
+                if (!registered) return;
+                own() = nullptr;
+                std::lock_guard<std::mutex> lock(mutex());
+                auto& all = readers();
+                for (auto& r : all) {
+                    if (r == &reader) {
+                        r = all.back();
+                        all.pop_back();
+                        break;
+                    }
+                }
+            }
+
+            // Tells if the calling thread's registration is gone (which
+            // happens when the thread ends; there may be destructors of
+            // other thread-local objects that still pin)
+            static bool& closed() noexcept {
+                static thread_local bool ret = false;
+                return ret;
+            }
+        };
+
+        // Registers a reader. Returns false if there's not enough memory.
+        inline bool enlist(Reader* reader) noexcept {
+            try {
+                std::lock_guard<std::mutex> lock(mutex());
+                readers().push_back(reader);
+                return true;
+            } catch(...) {
+                return false;
+            }
+        }
+
+        // Returns the reader of the calling thread, or nullptr if
+        // there's not enough memory
+        inline Reader* reader() noexcept {
+            auto& ret = own();
+            if (ret) return ret;
+
+            if (!Registration::closed()) {
+                static thread_local Registration registration;
+                if (enlist(&registration.reader)) {
+                    registration.registered = true;
+                    ret = &registration.reader;
+                }
+                return ret;
+            }
+
+            // Pinned after the thread's registration was destroyed:
+            // Borrow a spare reader until the pin ends (see release())
+            {
+                std::lock_guard<std::mutex> lock(mutex());
+                if (!spares().empty()) {
+                    ret = spares().back();
+                    spares().pop_back();
+                    return ret;
+                }
+            }
+
+            // None left: Make one, which is never freed (aligned by hand,
+            // since operator new doesn't align to a cache line)
+            const auto memory = new(std::nothrow) unsigned char[sizeof(Reader) + alignof(Reader)];
+            if (!memory) return nullptr;
+            const auto address = (reinterpret_cast<std::uintptr_t>(memory) + alignof(Reader) - 1) / alignof(Reader) * alignof(Reader);
+            const auto r = new(reinterpret_cast<void*>(address)) Reader;
+            if (enlist(r)) ret = r;
+            return ret;
+        }
+
+        // Called when the calling thread is unpinned. Gives back a
+        // reader that was borrowed after the thread's registration was
+        // destroyed; it stays in the list of readers, unpinned.
+        inline void release() noexcept {
+            if (!Registration::closed() || !own()) return;
+            std::lock_guard<std::mutex> lock(mutex());
+            try {
+                spares().push_back(own());
+                own() = nullptr;
+            } catch(...) {}
+        }
+
+        // Returns how deeply the calling thread is pinned
+        inline unsigned& depth() noexcept {
+            static thread_local unsigned ret = 0;
+            return ret;
+        }
+
+        // Returns the oldest epoch that a thread is pinned at, or
+        // UINT64_MAX if none is. Call with the mutex held.
+        inline std::uint64_t oldest() noexcept {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto ret = UINT64_MAX;
+            for (const auto r : readers()) {
+                const auto e = r->pinned.load();
+                if (e && e < ret) ret = e;
+            }
+            return ret;
+        }
+
+        // Frees the retired objects that no thread can read anymore.
+        // Call with the mutex held.
+        inline void reclaim() noexcept {
+            const auto min = oldest();
+            auto& all = retired();
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < all.size(); ++i) {
+                if (all[i].epoch < min) {
+                    all[i].destroy(all[i].object);
+                } else {
+                    all[kept++] = all[i];
+                }
+            }
+            all.resize(kept);
+        }
+
+        // Waits until no thread can read anything that was published
+        // before the call. Returns at once if the calling thread itself
+        // is pinned (it would wait for itself).
+        inline void synchronize() noexcept {
+            if (depth() > 0) return;
+            const auto e = global().fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex());
+                    if (oldest() > e) return;
+                }
+                std::this_thread::yield();
+            }
+        }
+
+        // Retires an object: destroy(object) is called once no thread
+        // can read it anymore. The object must be unreachable for new
+        // readers already.
+        inline void retire(void* object, void (*destroy)(void*)) noexcept {
+            {
+                std::lock_guard<std::mutex> lock(mutex());
+                try {
+                    retired().push_back(Retired{object, destroy, global().fetch_add(1)});
+                    reclaim();
+                    return;
+                } catch(...) {}
+            }
+
+            // No memory to remember the object: Wait for the readers
+            synchronize();
+            destroy(object);
+        }
+
+        template<typename T>
+        void retire(T* object) noexcept {
+            retire(object, [](void* p) { delete static_cast<T*>(p); });
+        }
+    }
+
+    /**
+     * Pin the registry's snapshots while this object exists. Views
+     * returned by plugins() and registrars() on this thread stay
+     * valid until it's destroyed, even if other threads register or
+     * unregister plug-ins in the meantime. Pins can be nested.
+     *
+     * Example:
+     *
+     *      const linktimeplugin::Pin pin;
+     *      for (const auto p : linktimeplugin::plugins<PluginBase>()) {
+     *          p->handle(request);
+     *      }
+     */
+    class Pin {
+    public:
+        Pin() noexcept
+        : reader_(epoch::depth()++ == 0 ? epoch::reader() : nullptr) {
+            // Sequentially consistent, like the registry's loads of its
+            // snapshots: The writers see the pin before this thread
+            // reads any snapshot
+            if (reader_) reader_->pinned.exchange(epoch::global().load());
+        }
+        ~Pin() {
+            if (reader_) {
+                reader_->pinned.store(0, std::memory_order_release);
+                epoch::release();
+            }
+            --epoch::depth();
+        }
+        Pin(const Pin&) = delete;
+        void operator=(const Pin&) = delete;
+    private:
+        epoch::Reader* reader_;
+    };
+}
@@ -0,0 +1,336 @@
+/**
+ * @brief Link-time plug-in management: Factory plug-ins
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "linktimeplugin.hpp"
+
+/**
+ * Factory plug-ins.
+ *
+ * A plug-in registered with REGISTER_PLUGIN has one instance. A plug-in
+ * registered with REGISTER_FACTORY_PLUGIN has as many as are created
+ * with linktimeplugin::create<Base>("key") (or through the factory that
+ * linktimeplugin::find<linktimeplugin::Factory<Base>>("key") returns),
+ * e. g. one per connection or job. Every instance is owned by the
+ * returned linktimeplugin::Instance<Base>, a std::unique_ptr that
+ * recycles the instance instead of deleting it.
+ *
+ * Recycled instances go to a free list of the thread that releases
+ * them (one per plug-in class and thread, with room for `capacity`
+ * instances), where the next create() on this thread picks them up, so
+ * creating and releasing instances costs no heap allocation once the
+ * free list is warm. If the plug-in class has a public member function
+ * reset(), it's called on recycling, and the instance is kept as it is
+ * for reuse; otherwise, the instance is destroyed on recycling and a
+ * new one is constructed in its memory on reuse. The init() hook, if
+ * the plug-in class has one, runs on every instance that's constructed.
+ *
+ * The factories are the plug-ins of linktimeplugin::Factory<Base>, so
+ * they can be enumerated, looked up, and frozen like any other. The
+ * instances are constructed by the factory's registrar, so their
+ * construction is profiled, traced, and booked on the plug-in's heap
+ * account like that of any other plug-in.
+ *
+ * Example:
+ *
+ *      class Session : public Handler {
+ *      public:
+ *          void reset() { buffer_.clear(); }
+ *      private:
+ *          std::string buffer_;
+ *      };
+ *      REGISTER_FACTORY_PLUGIN(Session, "session");
+ *
+ *      // For every connection
+ *      if (const auto session = linktimeplugin::create<Handler>("session")) {
+ *          session->handle(connection);
+ *      }
+ */
+namespace linktimeplugin {
+    /*
+     * Deleter of the instances of factory plug-ins: Returns the
+     * instance to the free list of its plug-in class.
+     */
+    template<typename BASE>
+    struct Recycle {
+        void (*recycle)(BASE*);
+
+        void operator()(BASE* instance) const noexcept {
+            recycle(instance);
+        }
+    };
+
+    // Instance of a factory plug-in
+    template<typename BASE>
+    using Instance = std::unique_ptr<BASE, Recycle<BASE>>;
+
+    /*
+     * Factory of one plug-in class. BASE is the plug-in base class.
+     * The factories of all factory plug-ins of BASE are the plug-ins
+     * of Factory<BASE>.
+     */
+    template<typename BASE>
+    class Factory {
+    public:
+        using Base = Factory<BASE>;
+
+        // Returns a new or recycled instance, or an empty pointer if
+        // there's not enough memory or the plug-in's ctor throws.
+        Instance<BASE> create() noexcept {
+            return Instance<BASE>(create_(*this), Recycle<BASE>{recycle_});
+        }
+
+    protected:
+        Factory(BASE* (*create)(Factory&), void (*recycle)(BASE*)) noexcept
+        : create_(create), recycle_(recycle) {}
+
+    private:
+        BASE* (*create_)(Factory&);
+        void (*recycle_)(BASE*);
+    };
+
+    template<typename PLUGIN>
+    class FactoryRegistrar;
+
+    /*
+     * The factory of one plug-in class, with the per-thread free lists
+     * of its instances.
+     * PLUGIN is the plug-in class (derived from the plug-in base class).
+     */
+    template<typename PLUGIN>
+    class Maker : public Factory<typename PLUGIN::Base> {
+        using Interface = typename PLUGIN::Base;
+
+    public:
+        // Number of instances that a thread keeps for reuse
+        static constexpr std::size_t capacity = 64;
+
+        explicit Maker(FactoryRegistrar<PLUGIN>& registrar) noexcept
+        : Factory<Interface>(&create, &recycle), registrar_(registrar) {}
+
+    private:
+        // Tells if the plug-in class has a reset() hook
+        template<typename T>
+        static auto resettable(int) -> decltype(std::declval<T&>().reset(), std::true_type());
+        template<typename T>
+        static std::false_type resettable(long);
+        static constexpr bool resets = decltype(resettable<PLUGIN>(0))::value;
+
+        // The free list of one thread: Recycled instances (if there's a
+        // reset() hook), or the memory of destroyed ones (if not).
+        struct Pool {
+            void* free[capacity];
+            std::size_t size = 0;
+
+            ~Pool() {
+                closed() = true;
+                while (size > 0) {
+                    const auto p = free[--size];
+                    if (resets) static_cast<PLUGIN*>(p)->~PLUGIN();
+                    deallocate<PLUGIN>(p);
+                }
+            }
+        };
+
+        // Returns the calling thread's free list
+        static Pool& pool() noexcept {
+            static thread_local Pool ret;
+            return ret;
+        }
+
+        // Tells if the calling thread's free list is gone (which happens
+        // when the thread ends). Instances recycled afterwards are deleted.
+        static bool& closed() noexcept {
+            static thread_local bool ret = false;
+            return ret;
+        }
+
+        // The registrar that constructs the instances
+        FactoryRegistrar<PLUGIN>& registrar_;
+
+        // Returns an instance from the free list, or a new one
+        static Interface* create(Factory<Interface>& factory) noexcept {
+            auto& registrar = static_cast<Maker&>(factory).registrar_;
+            if (!closed()) {
+                auto& p = pool();
+                if (p.size > 0) {
+                    const auto s = p.free[p.size - 1];
+                    if (resets) {
+                        --p.size;
+                        return static_cast<PLUGIN*>(s);
+                    }
+                    try {
+                        const auto ret = registrar.make(s);
+                        --p.size;
+                        return ret;
+                    } catch(...) {
+                        return nullptr;
+                    }
+                }
+            }
+
+            void* s = nullptr;
+            try {
+                s = allocate<PLUGIN>();
+                return registrar.make(s);
+            } catch(...) {
+                deallocate<PLUGIN>(s);
+                return nullptr;
+            }
+        }
+
+        // Puts an instance on the free list, or deletes it if the list
+        // is full or its reset() hook throws
+        static void recycle(Interface* instance) noexcept {
+            if (!instance) return;
+            const auto plugin = static_cast<PLUGIN*>(instance);
+            if (closed() || pool().size == capacity) {
+                plugin->~PLUGIN();
+                deallocate<PLUGIN>(plugin);
+                return;
+            }
+
+            if (!clean(*plugin, std::integral_constant<bool, resets>())) {
+                deallocate<PLUGIN>(plugin);
+                return;
+            }
+            auto& p = pool();
+            p.free[p.size++] = plugin;
+        }
+
+        // Prepares an instance for the free list. Returns false if
+        // it was destroyed instead.
+        static bool clean(PLUGIN& plugin, std::true_type) noexcept {
+            try {
+                plugin.reset();
+                return true;
+            } catch(...) {
+                plugin.~PLUGIN();
+                return false;
+            }
+        }
+        static bool clean(PLUGIN& plugin, std::false_type) noexcept {
+            plugin.~PLUGIN();
+            return true;
+        }
+    };
+
+    template<typename PLUGIN>
+    constexpr std::size_t Maker<PLUGIN>::capacity;
+    template<typename PLUGIN>
+    constexpr bool Maker<PLUGIN>::resets;
+
+    /*
+     * Derived registrar class for factory plug-ins: Registers the
+     * plug-in's factory as a plug-in of Factory<base class>, and
+     * constructs the instances that the factory creates. The budget
+     * applies to the plug-in class, i. e. to every instance, and is
+     * counted like for REGISTER_PLUGIN (see Footprint).
+     * PLUGIN is the plug-in class (derived from the plug-in base class).
+     */
+    template<typename PLUGIN>
+    class FactoryRegistrar : public RegistrarBase<Factory<typename PLUGIN::Base>> {
+        using Interface = typename PLUGIN::Base;
+
+    public:
+        // Ctor. The options are passed on to the registrar base class.
+        template<typename... OPTIONS>
+        explicit FactoryRegistrar(OPTIONS&&... options) noexcept
+        : RegistrarBase<Factory<Interface>>(std::forward<OPTIONS>(options)...), maker_(*this) {
+            static_assert(Footprint<PLUGIN>::value <= Limit<typename std::decay<OPTIONS>::type...>::value,
+                "The plug-in class exceeds its budget");
+            static_assert(!Has<Padded, typename std::decay<OPTIONS>::type...>::value,
+                "Only arena plug-ins can be padded");
+            this->template add<Maker<PLUGIN>>(&maker_);
+        }
+
+        // Dtor. Unregisters the factory before it's destroyed.
+        ~FactoryRegistrar() {
+            this->remove();
+        }
+
+    private:
+        friend class Maker<PLUGIN>;
+        Maker<PLUGIN> maker_;
+
+        // Constructs an instance in the given memory and runs its init()
+        // hook. Throws if the plug-in's ctor or init() throws (the
+        // instance is destroyed then).
+        PLUGIN* make(void* storage) {
+            const auto ret = this->template construct<PLUGIN>(storage);
+            try {
+                prepare(*ret, 0);
+            } catch(...) {
+                ret->~PLUGIN();
+                throw;
+            }
+            return ret;
+        }
+
+        // Runs the init() hook of a plug-in class that has one, booking
+        // its allocations. (The registrar's own hook is the factory's.)
+        template<typename T>
+        auto prepare(T& instance, int) -> decltype(instance.init(), void()) {
+#ifdef LINKTIMEPLUGIN_HEAP
+            const heap::Tag tag(this->account());
+#endif
+            instance.init();
+        }
+        template<typename T>
+        void prepare(T&, long) {}
+    };
+
+    /**
+     * Create an instance of the factory plug-in that was registered
+     * with the given key.
+     *
+     * T is the plug-in base class. Returns an empty pointer if no
+     * factory plug-in was registered with this key, or if the instance
+     * can't be created. The instance is recycled when the returned
+     * pointer is destroyed.
+     *
+     * Example:
+     *
+     *      if (const auto session = linktimeplugin::create<Handler>("session")) {
+     *          session->handle(connection);
+     *      }
+     */
+    template<typename T>
+    Instance<T> create(const char* key, std::size_t length) noexcept {
+        const auto f = find<Factory<T>>(key, length);
+        return f ? f->create() : Instance<T>();
+    }
+
+    template<typename T>
+    Instance<T> create(const char* key) noexcept {
+        return create<T>(key, std::strlen(key));
+    }
+
+    template<typename T>
+    Instance<T> create(const std::string& key) noexcept {
+        return create<T>(key.data(), key.size());
+    }
+}
+
+/**
+ * Register one plug-in class whose instances are created on demand
+ * with linktimeplugin::create(). Takes the same arguments as
+ * REGISTER_PLUGIN; the budget applies to every instance.
+ *
+ * Example:
+ *
+ *      REGISTER_FACTORY_PLUGIN(Session, "session");
+ */
+#define REGISTER_FACTORY_PLUGIN(...) LINKTIMEPLUGIN_REGISTER(FactoryRegistrar, __VA_ARGS__)
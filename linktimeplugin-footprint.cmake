@@ -0,0 +1,67 @@
+# Link-time plug-ins
+# Static footprint report, run by linktimeplugin_footprint() after
+# linking a target
+# by agent 2026-10-16
+#
+# Usage: cmake -DNM=nm -DBINARY=executable -DOUTPUT=report.txt
+#              -P linktimeplugin-footprint.cmake
+#
+# Lists the registrar objects that REGISTER_PLUGIN and
+# REGISTER_LAZY_PLUGIN define (named after the plug-in class with
+# "registrar" appended) with their sizes from the executable's symbol
+# table, largest first. A registrar holds the plug-in object (or the
+# storage for it), so its size is the plug-in's static footprint. It
+# includes the registrar base class, which linktimeplugin::budget<>()
+# leaves out: For REGISTER_PLUGIN, the budget applies to the registrar
+# size minus sizeof(RegistrarBase<Base>); lazy registrars add a lock
+# and a pointer to that.
+
+execute_process(
+    COMMAND ${NM} -C -S -t d ${BINARY}
+    OUTPUT_VARIABLE symbols
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(WARNING "Cannot read the symbols of ${BINARY}, no plug-in footprint report")
+    return()
+endif()
+
+# nm prints zero-padded decimal numbers, so the entries sort by size
+# as strings
+string(REPLACE "\n" ";" symbols "${symbols}")
+set(entries)
+foreach(symbol ${symbols})
+    if(symbol MATCHES "^[0-9]+ ([0-9]+) [bBdD] (.*)registrar$")
+        list(APPEND entries "${CMAKE_MATCH_1} ${CMAKE_MATCH_2}")
+    endif()
+endforeach()
+list(SORT entries)
+list(REVERSE entries)
+
+set(total 0)
+set(lines)
+foreach(entry ${entries})
+    string(REGEX MATCH "^([0-9]+) (.*)$" entry "${entry}")
+    set(bytes ${CMAKE_MATCH_1})
+    set(name ${CMAKE_MATCH_2})
+    # Without the leading zeros (a regular expression that's anchored
+    # with ^ would match again after every replacement)
+    string(REGEX MATCH "[1-9][0-9]*$" bytes "${bytes}")
+    if(NOT bytes)
+        set(bytes 0)
+    endif()
+    string(REGEX REPLACE "^\\(anonymous namespace\\)::" "" name "${name}")
+    math(EXPR total "${total} + ${bytes}")
+    string(LENGTH "${bytes}" length)
+    while(length LESS 10)
+        set(bytes " ${bytes}")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    set(lines "${lines}${bytes}  ${name}\n")
+endforeach()
+
+list(LENGTH entries count)
+get_filename_component(name ${BINARY} NAME)
+set(report "Plug-in registrars of ${name}: ${count} plug-ins, ${total} bytes\n registrar  plug-in\n${lines}")
+file(WRITE ${OUTPUT} "${report}")
+message("${report}")
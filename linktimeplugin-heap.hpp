@@ -0,0 +1,279 @@
+/**
+ * @brief Link-time plug-in management: Heap accounting
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+#include "linktimeplugin-profile.hpp"
+
+/**
+ * Heap accounting of link-time plug-ins.
+ *
+ * If LINKTIMEPLUGIN_HEAP is defined (for all translation units that
+ * register or call plug-ins), every registrar has an account, and the
+ * library tags the calling thread with it while the plug-in's ctor,
+ * its init() hook, and its calls through the dispatch helpers
+ * (linktimeplugin::for_each() and reduce()) run. The replacement of
+ * the global operator new and delete that LINKTIMEPLUGIN_HEAP_HOOKS()
+ * defines (put it into one source file of the program) books every
+ * allocation on the tagged account, and every deallocation on the
+ * account that the memory was allocated on, so the live bytes of a
+ * plug-in are right even if other code frees its memory.
+ *
+ * linktimeplugin::heap::accounts() returns the accounts of all
+ * plug-ins, linktimeplugin::heap::report() writes them, the plug-in
+ * with the most live bytes first. If the environment variable
+ * LINKTIMEPLUGIN_HEAP_REPORT is set when the first plug-in is
+ * registered, the report is written to stderr when the program exits.
+ *
+ * Every allocation carries a small header (not booked). Allocations
+ * with extended alignment (C++17 aligned new) aren't booked. Without
+ * LINKTIMEPLUGIN_HEAP, LINKTIMEPLUGIN_HEAP_HOOKS() is empty and the
+ * global operator new and delete are the default ones.
+ *
+ * Example:
+ *
+ *      // In one source file:
+ *      LINKTIMEPLUGIN_HEAP_HOOKS();
+ *
+ *      $ cmake -DLINKTIMEPLUGIN_HEAP=ON ..
+ *      $ make
+ *      $ LINKTIMEPLUGIN_HEAP_REPORT=1 ./demo1
+ */
+namespace linktimeplugin {
+    namespace heap {
+#ifdef LINKTIMEPLUGIN_HEAP
+        constexpr bool enabled = true;
+#else
+        constexpr bool enabled = false;
+#endif
+
+        /*
+         * The heap use of one plug-in. Updated by all threads.
+         */
+        struct Account {
+            std::string name;                           // Plug-in name
+            std::atomic<std::int64_t> live{0};          // Live bytes
+            std::atomic<std::int64_t> peak{0};          // Most live bytes
+            std::atomic<std::uint64_t> allocations{0};  // Allocations so far
+            std::atomic<std::uint64_t> deallocations{0};
+
+            void allocated(std::size_t size) noexcept {
+                const auto now = live.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed)
+                    + static_cast<std::int64_t>(size);
+                auto p = peak.load(std::memory_order_relaxed);
+                while (now > p && !peak.compare_exchange_weak(p, now, std::memory_order_relaxed)) {}
+                allocations.fetch_add(1, std::memory_order_relaxed);
+            }
+            void deallocated(std::size_t size) noexcept {
+                live.fetch_sub(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+                deallocations.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        /*
+         * Snapshot of an account
+         */
+        struct Usage {
+            std::string name;
+            std::int64_t live;
+            std::int64_t peak;
+            std::uint64_t allocations;
+            std::uint64_t deallocations;
+        };
+
+        // The accounts of all plug-ins, and the mutex that protects the
+        // list. They're never freed, so that memory can be booked back
+        // on them at any time.
+        inline std::deque<Account>& all() noexcept {
+            static const auto ret = new std::deque<Account>;
+            return *ret;
+        }
+        inline std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // The account that the calling thread's allocations are booked
+        // on (nullptr: none)
+        inline Account*& current() noexcept {
+            static thread_local Account* ret = nullptr;
+            return ret;
+        }
+
+        /*
+         * Books the calling thread's allocations on an account while
+         * it exists
+         */
+        class Tag {
+        public:
+            explicit Tag(Account* account) noexcept
+            : previous_(current()) {
+                current() = account;
+            }
+            ~Tag() {
+                current() = previous_;
+            }
+            Tag(const Tag&) = delete;
+            void operator=(const Tag&) = delete;
+        private:
+            Account* previous_;
+        };
+
+        /**
+         * Get the heap use of all plug-ins, in order of registration.
+         */
+        inline std::vector<Usage> accounts() {
+            std::vector<Usage> ret;
+            std::lock_guard<std::mutex> lock(mutex());
+            for (const auto& a : all()) {
+                ret.push_back(Usage{a.name, a.live.load(), a.peak.load(), a.allocations.load(), a.deallocations.load()});
+            }
+            return ret;
+        }
+
+        /**
+         * Write the heap use of all plug-ins, the plug-in with the most
+         * live bytes first.
+         */
+        inline void report(std::ostream& os) {
+            auto r = accounts();
+            std::stable_sort(r.begin(), r.end(), [](const Usage& a, const Usage& b) {
+                return a.live > b.live;
+            });
+            os << "Plug-in heap report: " << r.size() << " plug-ins\n"
+                << std::setw(14) << "live bytes" << std::setw(14) << "peak bytes"
+                << std::setw(12) << "allocs" << std::setw(12) << "live allocs" << "  plug-in\n";
+            for (const auto& u : r) {
+                os << std::setw(14) << u.live << std::setw(14) << u.peak
+                    << std::setw(12) << u.allocations
+                    << std::setw(12) << static_cast<std::int64_t>(u.allocations - u.deallocations)
+                    << "  " << u.name << '\n';
+            }
+        }
+
+        // Opens the account of a plug-in. Called by the registrar.
+        // Returns nullptr if there's not enough memory.
+        inline Account* open(const char* name) noexcept {
+            const Tag untagged(nullptr);
+            try {
+                std::lock_guard<std::mutex> lock(mutex());
+                if (all().empty() && std::getenv("LINKTIMEPLUGIN_HEAP_REPORT")) {
+                    std::atexit([] {
+                        const Tag untagged(nullptr);
+                        report(std::cerr);
+                    });
+                }
+                all().emplace_back();
+                all().back().name = name ? name : "";
+                return &all().back();
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        // Renames an account. Called by the registrar.
+        inline void rename(Account* account, const std::string& name) noexcept {
+            const Tag untagged(nullptr);
+            if (!account) return;
+            try {
+                std::lock_guard<std::mutex> lock(mutex());
+                account->name = name;
+            } catch(...) {}
+        }
+
+        /*
+         * Allocation and deallocation with accounting, for the global
+         * operator new and delete. Every block has a header with the
+         * account it's booked on and its size.
+         */
+        struct Header {
+            Account* account;
+            std::size_t size;
+        };
+        constexpr std::size_t header = alignof(std::max_align_t) > sizeof(Header)
+            ? alignof(std::max_align_t) : sizeof(Header);
+
+        inline void* allocate(std::size_t size) noexcept {
+            const auto p = static_cast<unsigned char*>(std::malloc(header + size));
+            if (!p) return nullptr;
+            const auto account = current();
+            ::new(p) Header{account, size};
+            if (account) account->allocated(size);
+            return p + header;
+        }
+
+        inline void deallocate(void* ptr) noexcept {
+            if (!ptr) return;
+            const auto p = static_cast<unsigned char*>(ptr) - header;
+            const auto h = reinterpret_cast<Header*>(p);
+            if (h->account) h->account->deallocated(h->size);
+            std::free(p);
+        }
+    }
+}
+
+// Marks a replacement of the global operator new or delete. They aren't
+// inlined, so the compiler sees every allocation paired with its
+// matching operator delete rather than with the malloc() and free()
+// inside them (which it would warn about). Also used by the benchmarks
+// that count allocations.
+#if defined(__GNUC__) || defined(__clang__)
+#define LINKTIMEPLUGIN_HEAP_NOINLINE __attribute__((noinline))
+#else
+#define LINKTIMEPLUGIN_HEAP_NOINLINE
+#endif
+
+/**
+ * Replace the global operator new and delete with ones that book the
+ * allocations on the plug-in accounts. Use this in one source file of
+ * the program if LINKTIMEPLUGIN_HEAP is defined; it's empty otherwise.
+ */
+#ifdef LINKTIMEPLUGIN_HEAP
+#define LINKTIMEPLUGIN_HEAP_HOOKS() \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void* operator new(std::size_t size) { \
+        for (;;) { \
+            if (const auto p = linktimeplugin::heap::allocate(size)) return p; \
+            const auto handler = std::get_new_handler(); \
+            if (!handler) throw std::bad_alloc(); \
+            handler(); \
+        } \
+    } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void* operator new[](std::size_t size) { return ::operator new(size); } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void* operator new(std::size_t size, const std::nothrow_t&) noexcept { \
+        try { return ::operator new(size); } catch(...) { return nullptr; } \
+    } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { \
+        try { return ::operator new(size); } catch(...) { return nullptr; } \
+    } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete(void* p) noexcept { linktimeplugin::heap::deallocate(p); } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete[](void* p) noexcept { ::operator delete(p); } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete(void* p, const std::nothrow_t&) noexcept { ::operator delete(p); } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete[](void* p, const std::nothrow_t&) noexcept { ::operator delete(p); } \
+    LINKTIMEPLUGIN_HEAP_SIZED_DELETE \
+    static_assert(true, "")
+#if defined(__cpp_sized_deallocation)
+#define LINKTIMEPLUGIN_HEAP_SIZED_DELETE \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); } \
+    LINKTIMEPLUGIN_HEAP_NOINLINE void operator delete[](void* p, std::size_t) noexcept { ::operator delete(p); }
+#else
+#define LINKTIMEPLUGIN_HEAP_SIZED_DELETE
+#endif
+#else
+#define LINKTIMEPLUGIN_HEAP_HOOKS() static_assert(true, "")
+#endif
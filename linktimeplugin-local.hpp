@@ -0,0 +1,378 @@
+/**
+ * @brief Link-time plug-in management: Per-thread plug-in instances
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "linktimeplugin.hpp"
+
+/**
+ * Per-thread instances of link-time plug-ins.
+ *
+ * A plug-in registered with REGISTER_PLUGIN exists once, so a plug-in
+ * that caches or accumulates something must lock when several threads
+ * use it. A plug-in registered with REGISTER_LOCAL_PLUGIN instead gets
+ * an instance per thread, constructed when the thread uses it first,
+ * plus a shared instance, which is the one that plugins() and find()
+ * return. linktimeplugin::local::plugins() and linktimeplugin::local::
+ * find() return the calling thread's instances: Its own ones of the
+ * per-thread plug-ins, and the shared ones of all others.
+ *
+ * When a thread ends, or calls linktimeplugin::local::flush(), its
+ * instances are merged into the shared ones and destroyed. To merge,
+ * give the plug-in class a public member function merge(PLUGIN&): It's
+ * called on the shared instance with the per-thread instance, so the
+ * shared instance aggregates the state of all threads. Merges are
+ * serialized; threads that read the shared instance while others merge
+ * into it must synchronize with them (or read after joining them).
+ *
+ * Per-thread instances are default-constructed, and the init() hook
+ * runs on them before they're used, like on the shared instance. A
+ * thread gets no instance of its own as long as the shared instance
+ * can't be constructed. Unregistering a per-thread plug-in destroys the
+ * instances of all threads; like with shared plug-ins, threads that may
+ * use it at the same time hold a linktimeplugin::Pin while they do.
+ *
+ * Example:
+ *
+ *      class Counter : public PluginBase {
+ *      public:
+ *          void handle(const Request&) override { ++count_; }
+ *          void merge(Counter& other) { count_ += other.count_; }
+ *      private:
+ *          std::size_t count_ = 0;
+ *      };
+ *      REGISTER_LOCAL_PLUGIN(Counter, "counter");
+ *
+ *      // In the worker threads
+ *      for (const auto p : linktimeplugin::local::plugins<PluginBase>()) {
+ *          p->handle(request);
+ *      }
+ */
+namespace linktimeplugin {
+    namespace local {
+        /*
+         * One thread's instance of one per-thread plug-in
+         */
+        struct Entry {
+            void* instance;                                 // The instance, or nullptr
+            void* registrar;                                // Its registrar
+            void (*release)(void* registrar, Entry& entry); // Merges and destroys it
+        };
+
+        /*
+         * The instances of one thread, indexed by the slot numbers of
+         * their registrars. The entries don't move when the deque
+         * grows, so registrars can refer to them.
+         */
+        struct Instances {
+            std::deque<Entry> entries;
+            ~Instances();
+        };
+
+        // The mutex that protects the registrars' lists of instances,
+        // the entries (which the owning thread reads without it, though),
+        // and the slot numbers, and that serializes the merges. Never
+        // freed, so that threads can end until the program ends.
+        inline std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // Returns the calling thread's instances
+        inline Instances& instances() noexcept {
+            static thread_local Instances ret;
+            return ret;
+        }
+
+        // Returns a number that changes whenever the calling thread's
+        // instances are destroyed
+        inline std::uint64_t& generation() noexcept {
+            static thread_local std::uint64_t ret = 0;
+            return ret;
+        }
+
+        // The slot numbers of destroyed registrars, which are reused.
+        // Call with the mutex held.
+        inline std::vector<std::size_t>& slots() noexcept {
+            static const auto ret = new std::vector<std::size_t>;
+            return *ret;
+        }
+
+        // Returns an unused slot number. Call with the mutex held.
+        inline std::size_t slot() noexcept {
+            static std::size_t next = 0;
+            auto& free = slots();
+            if (free.empty()) return next++;
+            const auto ret = free.back();
+            free.pop_back();
+            return ret;
+        }
+
+        // Merges a thread's instances into the shared ones and
+        // destroys them
+        inline void flush(Instances& instances) noexcept {
+            std::lock_guard<std::mutex> lock(mutex());
+            for (auto& e : instances.entries) {
+                if (e.instance) e.release(e.registrar, e);
+            }
+            ++generation();
+        }
+
+        inline Instances::~Instances() {
+            flush(*this);
+        }
+
+        /**
+         * Merge the calling thread's instances of the per-thread
+         * plug-ins into the shared ones, and destroy them. Threads
+         * that live long (e. g. in a thread pool) call this after a
+         * batch of work; the next use constructs new instances.
+         * Invalidates the views returned by local::plugins().
+         */
+        inline void flush() noexcept {
+            flush(instances());
+        }
+
+        // Calls the merge() hook of a plug-in class that has one
+        template<typename PLUGIN>
+        auto merge(PLUGIN& shared, PLUGIN& instance, int) -> decltype(shared.merge(instance), void()) {
+            shared.merge(instance);
+        }
+        template<typename PLUGIN>
+        void merge(PLUGIN&, PLUGIN&, long) {}
+
+        /**
+         * Get pointers to the calling thread's instances of all
+         * registered plug-in classes.
+         *
+         * T is the plug-in base class.
+         *
+         * Like linktimeplugin::plugins(), but per-thread plug-ins are
+         * represented by the calling thread's instance, which is
+         * constructed by the first call. The view is cached per thread
+         * and rebuilt only after the registry changes or flush() is
+         * called. Hold a linktimeplugin::Pin while using it if other
+         * threads may unregister plug-ins.
+         */
+        template<typename T>
+        Plugins<T> plugins() noexcept {
+            struct Cache {
+                std::uint64_t version = 0;
+                std::uint64_t generation = 0;
+                std::vector<T*> plugins;
+            };
+            static thread_local Cache cache;
+
+            const auto version = RegistrarBase<T>::version();
+            if (cache.version != version || cache.generation != generation()) {
+                const Pin pin;
+                cache.plugins.clear();
+                try {
+                    for (const auto r : RegistrarBase<T>::registrars()) {
+                        if (r->failed()) continue;
+                        if (const auto p = r->local()) {
+                            cache.plugins.push_back(p);
+                        }
+                    }
+                    cache.version = version;
+                    cache.generation = generation();
+                } catch(...) {
+                    cache.version = 0;
+                    return Plugins<T>();
+                }
+            }
+            return Plugins<T>(cache.plugins.data(), cache.plugins.size());
+        }
+
+        /**
+         * Get the calling thread's instance of the plug-in that was
+         * registered with the given key, or nullptr.
+         *
+         * T is the plug-in base class.
+         */
+        template<typename T>
+        T* find(const char* key, std::size_t length) noexcept {
+            const Pin pin;
+            const auto r = RegistrarBase<T>::registrar(key, length);
+            return r && !r->failed() ? r->local() : nullptr;
+        }
+
+        template<typename T>
+        T* find(const char* key) noexcept {
+            return find<T>(key, std::strlen(key));
+        }
+
+        template<typename T>
+        T* find(const std::string& key) noexcept {
+            return find<T>(key.data(), key.size());
+        }
+    }
+
+    /*
+     * Derived registrar class for plug-ins that have an instance per
+     * thread. The shared instance is constructed on first use, like
+     * with LazyRegistrar.
+     * PLUGIN is the plug-in class (derived from the plug-in base class).
+     */
+    template<typename PLUGIN>
+    class LocalRegistrar : public RegistrarBase<typename PLUGIN::Base> {
+        using Base = typename PLUGIN::Base;
+        using Storage = typename std::aligned_storage<sizeof(PLUGIN), alignof(PLUGIN)>::type;
+
+    public:
+        // Ctor. The options are passed on to the registrar base class.
+        template<typename... OPTIONS>
+        explicit LocalRegistrar(OPTIONS&&... options) noexcept
+        : RegistrarBase<Base>(std::forward<OPTIONS>(options)...) {
+            static_assert(Footprint<PLUGIN>::value <= Limit<typename std::decay<OPTIONS>::type...>::value,
+                "The plug-in class exceeds its budget");
+            static_assert(!Has<Padded, typename std::decay<OPTIONS>::type...>::value,
+                "Only arena plug-ins can be padded");
+            {
+                std::lock_guard<std::mutex> lock(local::mutex());
+                slot_ = local::slot();
+            }
+            this->template add<PLUGIN, &make, &own>(nullptr);
+        }
+
+        // Dtor. Unregisters the plug-in, then destroys the instances of
+        // all threads (without merging them) and the shared instance.
+        // The other threads read their instances without locking, so
+        // they must not use them anymore: remove() waits for the threads
+        // that hold a Pin, so threads that may use the plug-in while
+        // it's unregistered hold one while they do (like with shared
+        // instances); otherwise, unregister it only while no other
+        // thread uses it.
+        ~LocalRegistrar() {
+            this->remove();
+            {
+                std::lock_guard<std::mutex> lock(local::mutex());
+                for (const auto e : instances_) {
+                    destroy(static_cast<PLUGIN*>(e->instance));
+                    e->instance = nullptr;
+                }
+                try {
+                    local::slots().push_back(slot_);
+                } catch(...) {}
+            }
+            if (const auto p = instance_.load()) p->~PLUGIN();
+        }
+
+    private:
+        Storage storage_;
+        std::mutex mutex_;
+        std::atomic<PLUGIN*> instance_{nullptr};
+
+        // The slot of this registrar's entries in the threads'
+        // instances, and these entries (changed under local::mutex())
+        std::size_t slot_;
+        std::vector<local::Entry*> instances_;
+
+        // Constructs the shared instance exactly once, like LazyRegistrar
+        static Base* make(RegistrarBase<Base>& registrar) {
+            auto& self = static_cast<LocalRegistrar&>(registrar);
+            if (const auto p = self.instance_.load(std::memory_order_acquire)) {
+                return p;
+            }
+            std::lock_guard<std::mutex> lock(self.mutex_);
+            if (const auto p = self.instance_.load(std::memory_order_relaxed)) {
+                return p;
+            }
+            const auto ret = self.template construct<PLUGIN>(&self.storage_);
+            self.instance_.store(ret, std::memory_order_release);
+            return ret;
+        }
+
+        // Returns the calling thread's instance, constructing it and
+        // running its init() hook on first use. Throws if the plug-in's
+        // ctor or init() throws, or if the shared instance can't be
+        // constructed.
+        static Base* own(RegistrarBase<Base>& registrar) {
+            auto& self = static_cast<LocalRegistrar&>(registrar);
+            auto& all = local::instances();
+            if (self.slot_ < all.entries.size()) {
+                if (const auto p = all.entries[self.slot_].instance) {
+                    return static_cast<PLUGIN*>(p);
+                }
+            }
+
+            // Construct the shared instance now, outside local::mutex(),
+            // so that release() has one to merge into without
+            // constructing it (a ctor that uses local:: would deadlock).
+            // Without it, the thread's state would be lost on release(),
+            // so there's no instance for the thread either.
+            self();
+
+            const auto storage = allocate<PLUGIN>();
+            PLUGIN* ret;
+            try {
+                ret = self.template construct<PLUGIN>(storage);
+            } catch(...) {
+                deallocate<PLUGIN>(storage);
+                throw;
+            }
+            try {
+                self.init(*ret);
+                std::lock_guard<std::mutex> lock(local::mutex());
+                if (all.entries.size() <= self.slot_) {
+                    all.entries.resize(self.slot_ + 1, local::Entry{nullptr, nullptr, nullptr});
+                }
+                auto& e = all.entries[self.slot_];
+                self.instances_.push_back(&e);
+                e = local::Entry{ret, &self, &release};
+            } catch(...) {
+                destroy(ret);
+                throw;
+            }
+            return ret;
+        }
+
+        // Merges a thread's instance into the shared one (which own()
+        // constructed, if it could) and destroys it. Called with
+        // local::mutex() held, by the thread that owns the instance.
+        static void release(void* registrar, local::Entry& entry) noexcept {
+            auto& self = *static_cast<LocalRegistrar*>(registrar);
+            const auto instance = static_cast<PLUGIN*>(entry.instance);
+            entry.instance = nullptr;
+            self.instances_.erase(std::find(self.instances_.begin(), self.instances_.end(), &entry));
+
+            if (const auto shared = self.instance_.load()) {
+                try {
+                    local::merge(static_cast<PLUGIN&>(*shared), *instance, 0);
+                } catch(...) {}
+            }
+            destroy(instance);
+        }
+
+        // Destroys a thread's instance
+        static void destroy(PLUGIN* instance) noexcept {
+            instance->~PLUGIN();
+            deallocate<PLUGIN>(instance);
+        }
+    };
+}
+
+/**
+ * Register one plug-in class that has an instance per thread. Takes the
+ * same arguments as REGISTER_PLUGIN.
+ *
+ * Example:
+ *
+ *      REGISTER_LOCAL_PLUGIN(Plugin, "plugin");
+ */
+#define REGISTER_LOCAL_PLUGIN(...) LINKTIMEPLUGIN_REGISTER(LocalRegistrar, __VA_ARGS__)
@@ -0,0 +1,361 @@
+/**
+ * @brief Link-time plug-in management: Call metrics
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-heap.hpp"
+#include "linktimeplugin-profile.hpp"
+#include "linktimeplugin-trace.hpp"
+
+/**
+ * Call metrics of link-time plug-ins.
+ *
+ * If the plug-in base class has a member "static constexpr bool
+ * metrics = true", every call of a plug-in through the library's
+ * dispatch helpers (linktimeplugin::for_each() and reduce()) is counted
+ * and its duration recorded in a histogram. Every thread records into
+ * a shard of its own, so the calls take no lock. Without the member,
+ * the helpers are exactly as they were.
+ *
+ * linktimeplugin::metrics::collect() sums up the shards of all threads,
+ * linktimeplugin::metrics::report() writes the result, the plug-in
+ * with the most time spent in it first.
+ *
+ * Example:
+ *
+ *      class PluginBase {
+ *      public:
+ *          using Base = PluginBase;
+ *          static constexpr bool metrics = true;
+ *          virtual void handle(Request&) = 0;
+ *      };
+ *
+ *      linktimeplugin::for_each<PluginBase>([&](PluginBase* p) { p->handle(request); });
+ *      linktimeplugin::metrics::report<PluginBase>(std::cerr);
+ */
+namespace linktimeplugin {
+    namespace metrics {
+        /*
+         * Tells if the metrics of a plug-in base class are enabled.
+         */
+        template<typename BASE, typename = void>
+        struct Enabled : std::false_type {};
+        template<typename BASE>
+        struct Enabled<BASE, typename std::enable_if<BASE::metrics>::type> : std::true_type {};
+
+        /*
+         * Tells if the dispatch helpers measure the calls of the plug-ins
+         * of a plug-in base class: If its metrics are enabled, if trace
+         * events are recorded (see linktimeplugin-trace.hpp), if there
+         * are probes (see linktimeplugin-probes.hpp), or if the heap use
+         * is booked (see linktimeplugin-heap.hpp).
+         */
+        template<typename BASE>
+        struct Instrumented : std::integral_constant<bool,
+            Enabled<BASE>::value || trace::enabled || probes::enabled || heap::enabled> {};
+
+        /*
+         * Latency histogram in the style of HdrHistogram: 16 linear
+         * buckets per power of two, so every bucket is at most 1/16th
+         * (6.25 %) wide relative to its values, from 0 to 2^40 ns (about
+         * 18 minutes; longer calls are counted in the last bucket).
+         */
+        struct Histogram {
+            static constexpr unsigned bits = 4;
+            static constexpr unsigned magnitudes = 40;
+            static constexpr std::size_t size = std::size_t(magnitudes - bits + 1) << bits;
+
+            // Returns the bucket of a value
+            static std::size_t bucket(std::uint64_t v) noexcept {
+                if (v >= std::uint64_t(1) << magnitudes) return size - 1;
+                if (v < std::uint64_t(1) << bits) return static_cast<std::size_t>(v);
+                const auto e = log2(v);
+                return (std::size_t(e - bits + 1) << bits) + static_cast<std::size_t>(v >> (e - bits)) - (std::size_t(1) << bits);
+            }
+
+            // Returns the position of the highest bit that's set in a
+            // value other than 0
+            static unsigned log2(std::uint64_t v) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#else
+                unsigned ret = 0;
+                while (v >>= 1) ++ret;
+                return ret;
+#endif
+            }
+
+            // Returns the highest value of a bucket
+            static std::uint64_t highest(std::size_t b) noexcept {
+                if (b < std::size_t(1) << bits) return b;
+                const auto g = static_cast<unsigned>(b >> bits);
+                const auto m = (b & ((std::size_t(1) << bits) - 1)) + (std::size_t(1) << bits);
+                return ((std::uint64_t(m) + 1) << (g - 1)) - 1;
+            }
+        };
+
+        /*
+         * What one thread recorded about one plug-in. Only the owning
+         * thread writes it (with plain loads and stores, no atomic
+         * read-modify-write); collect() reads it at any time.
+         */
+        struct Stats {
+            std::atomic<std::uint64_t> calls{0};
+            std::atomic<std::uint64_t> total{0};        // Nanoseconds
+            std::atomic<std::uint64_t> max{0};
+            std::atomic<std::uint64_t> buckets[Histogram::size] = {};
+
+            void record(std::uint64_t ns) noexcept {
+                const auto add = [](std::atomic<std::uint64_t>& a, std::uint64_t v) {
+                    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+                };
+                add(calls, 1);
+                add(total, ns);
+                add(buckets[Histogram::bucket(ns)], 1);
+                if (ns > max.load(std::memory_order_relaxed)) max.store(ns, std::memory_order_relaxed);
+            }
+        };
+
+        /*
+         * The stats of one thread, one per registrar (by its id, see
+         * RegistrarBase<BASE>::id()). The owning thread reads
+         * the vector without locking; it takes the mutex only to grow
+         * it, and collect() takes it to read it.
+         */
+        struct Shard {
+            std::mutex mutex;
+            std::vector<std::unique_ptr<Stats>> stats;
+        };
+
+        // The shards of all threads of one plug-in base class. They're
+        // never freed, so the calls of threads that ended are still
+        // counted.
+        template<typename BASE>
+        struct Shards {
+            static std::vector<Shard*>& all() noexcept {
+                static const auto ret = new std::vector<Shard*>;
+                return *ret;
+            }
+            static std::mutex& mutex() noexcept {
+                static const auto ret = new std::mutex;
+                return *ret;
+            }
+
+            // Returns the shard of the calling thread, or nullptr if
+            // there's not enough memory
+            static Shard* mine() noexcept {
+                static thread_local Shard* shard = nullptr;
+                if (!shard) {
+                    try {
+                        std::unique_ptr<Shard> s(new Shard);
+                        std::lock_guard<std::mutex> lock(mutex());
+                        all().push_back(s.get());
+                        shard = s.release();
+                    } catch(...) {}
+                }
+                return shard;
+            }
+        };
+
+        // Records the duration of one call of the plug-in of the
+        // registrar with the given id
+        template<typename BASE>
+        void record(std::size_t id, std::uint64_t ns) noexcept {
+            const auto shard = Shards<BASE>::mine();
+            if (!shard) return;
+            if (id >= shard->stats.size() || !shard->stats[id]) {
+                try {
+                    std::unique_ptr<Stats> s(new Stats);
+                    std::lock_guard<std::mutex> lock(shard->mutex);
+                    if (id >= shard->stats.size()) shard->stats.resize(id + 1);
+                    shard->stats[id] = std::move(s);
+                } catch(...) {
+                    return;
+                }
+            }
+            shard->stats[id]->record(ns);
+        }
+
+        // Measures one call of the plug-in of a registrar (at the given
+        // position in the dispatch, which the probes report) until it's
+        // destroyed, also if the call throws, and
+        // books the call's allocations on the plug-in's heap account.
+        // The clock is read only if the metrics are enabled or trace
+        // events are recorded; the probes and the heap accounts don't
+        // need it.
+        template<typename BASE>
+        class Timer {
+            static constexpr bool timed = Enabled<BASE>::value || trace::enabled;
+
+        public:
+            Timer(const RegistrarBase<BASE>& registrar, std::size_t position) noexcept
+            : registrar_(registrar), position_(position),
+#ifdef LINKTIMEPLUGIN_HEAP
+            tag_(registrar.account()),
+#endif
+            start_(timed ? profile::now() : 0) {
+                LINKTIMEPLUGIN_PROBE3(call_start, typeid(BASE).name(), registrar_.site().name, position_);
+            }
+            ~Timer() {
+                LINKTIMEPLUGIN_PROBE3(call_done, typeid(BASE).name(), registrar_.site().name, position_);
+                if (!timed) return;
+                const auto end = profile::now();
+                if (Enabled<BASE>::value) {
+                    record<BASE>(registrar_.id(), static_cast<std::uint64_t>(end - start_));
+                }
+                if (trace::enabled) {
+                    trace::complete("call", registrar_.site().name, trace::name<BASE>(), start_, end);
+                }
+            }
+            Timer(const Timer&) = delete;
+            void operator=(const Timer&) = delete;
+        private:
+            const RegistrarBase<BASE>& registrar_;
+            std::size_t position_;
+#ifdef LINKTIMEPLUGIN_HEAP
+            heap::Tag tag_;
+#endif
+            std::int64_t start_;
+        };
+
+        template<typename BASE>
+        constexpr bool Timer<BASE>::timed;
+
+        /*
+         * Metrics of one plug-in, summed up over all threads. Times are
+         * in nanoseconds; the percentiles are the highest value of the
+         * histogram bucket they fall into.
+         */
+        struct Summary {
+            std::string name;               // Key, or class name
+            std::uint64_t calls;
+            std::uint64_t total;
+            std::uint64_t max;
+            std::uint64_t p50, p90, p99, p999;
+        };
+
+        /**
+         * Sum up the metrics of all plug-ins of one plug-in base class
+         * over all threads. Returns one summary per plug-in that was
+         * called at least once, in order of registration.
+         *
+         * T is the plug-in base class.
+         */
+        template<typename T>
+        std::vector<Summary> collect() {
+            static_assert(Enabled<T>::value, "Metrics aren't enabled for this plug-in base class");
+
+            // Sum up the shards
+            const Pin pin;
+            const auto registrars = RegistrarBase<T>::registrars();
+            std::vector<std::uint64_t> calls(registrars.size()), total(calls), max(calls);
+            std::vector<std::vector<std::uint64_t>> buckets(registrars.size());
+            {
+                std::lock_guard<std::mutex> lock(Shards<T>::mutex());
+                for (const auto shard : Shards<T>::all()) {
+                    std::lock_guard<std::mutex> lock(shard->mutex);
+                    for (std::size_t i = 0; i < registrars.size(); ++i) {
+                        const auto id = registrars[i]->id();
+                        if (id >= shard->stats.size()) continue;
+                        const auto& s = shard->stats[id];
+                        if (!s) continue;
+                        calls[i] += s->calls.load(std::memory_order_relaxed);
+                        total[i] += s->total.load(std::memory_order_relaxed);
+                        max[i] = std::max(max[i], s->max.load(std::memory_order_relaxed));
+                        buckets[i].resize(std::size_t(Histogram::size));
+                        for (std::size_t b = 0; b < Histogram::size; ++b) {
+                            buckets[i][b] += s->buckets[b].load(std::memory_order_relaxed);
+                        }
+                    }
+                }
+            }
+
+            std::vector<Summary> ret;
+            for (std::size_t i = 0; i < registrars.size(); ++i) {
+                if (!calls[i]) continue;
+
+                // Percentiles from the histogram, ranked by its own count
+                // (the owning threads count a call before they put it in
+                // a bucket, so the buckets may hold fewer calls than
+                // counted)
+                std::uint64_t p[4];
+                const double fractions[] = { 0.5, 0.9, 0.99, 0.999 };
+                std::uint64_t counted = 0;
+                for (const auto n : buckets[i]) counted += n;
+                std::uint64_t seen = 0;
+                std::size_t b = 0;
+                for (auto f = 0; f < 4; ++f) {
+                    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(fractions[f] * static_cast<double>(counted) + 0.5));
+                    while (b < Histogram::size - 1 && seen + buckets[i][b] < rank) seen += buckets[i][b++];
+                    p[f] = std::min(Histogram::highest(b), max[i]);
+                }
+
+                // Name the plug-in by its key or class name
+                const auto r = registrars[i];
+                std::string name;
+                if (r->key()) {
+                    name = r->key();
+                } else if (r->site().name) {
+                    name = r->site().name;
+                } else if (const auto plugin = r->get()) {
+                    name = profile::name(typeid(*plugin));
+                }
+                ret.push_back(Summary{name, calls[i], total[i], max[i], p[0], p[1], p[2], p[3]});
+            }
+            return ret;
+        }
+
+        /**
+         * Write the metrics of all plug-ins of one plug-in base class,
+         * the plug-in with the most time spent in it first. Times are
+         * in microseconds.
+         *
+         * T is the plug-in base class.
+         */
+        template<typename T>
+        void report(std::ostream& os) {
+            auto all = collect<T>();
+            std::stable_sort(all.begin(), all.end(), [](const Summary& a, const Summary& b) {
+                return a.total > b.total;
+            });
+
+            const auto us = [](double ns) {
+                std::ostringstream ret;
+                ret << std::fixed << std::setprecision(1) << ns / 1e3;
+                return ret.str();
+            };
+            os << std::setw(12) << "calls" << std::setw(12) << "total us"
+                << std::setw(10) << "mean us" << std::setw(10) << "p50 us"
+                << std::setw(10) << "p99 us" << std::setw(10) << "p99.9 us"
+                << std::setw(10) << "max us" << "  plug-in\n";
+            for (const auto& s : all) {
+                os << std::setw(12) << s.calls
+                    << std::setw(12) << us(static_cast<double>(s.total))
+                    << std::setw(10) << us(static_cast<double>(s.total) / static_cast<double>(s.calls))
+                    << std::setw(10) << us(static_cast<double>(s.p50))
+                    << std::setw(10) << us(static_cast<double>(s.p99))
+                    << std::setw(10) << us(static_cast<double>(s.p999))
+                    << std::setw(10) << us(static_cast<double>(s.max))
+                    << "  " << s.name << '\n';
+            }
+        }
+    }
+}
@@ -0,0 +1,490 @@
+/**
+ * @brief Link-time plug-in management: Parallel operations
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-metrics.hpp"
+
+/**
+ * Parallel operations on link-time plug-ins.
+ *
+ * Requires linking with the platform's thread library
+ * (Threads::Threads in CMake).
+ */
+namespace linktimeplugin {
+    /*
+     * Execution policies for for_each() and reduce()
+     */
+    struct Serial {};
+    struct Parallel {
+        unsigned threads;       // Maximum number of threads (0: all)
+    };
+    constexpr Serial serial{};
+    constexpr Parallel parallel{0};
+
+    /*
+     * Work-stealing thread pool. The worker threads are started on
+     * first use and run until the program ends.
+     *
+     * run() distributes the indices [0, count) over the participating
+     * threads (the calling thread is one of them) in equal ranges.
+     * Every thread takes the indices of its own range from the front;
+     * when its range is empty, it steals the back half of another
+     * thread's range. A range is a single atomic word (begin and end),
+     * so taking and stealing is a compare-and-swap, without locks.
+     */
+    class Pool {
+    public:
+        // Returns the pool, starting it if necessary
+        static Pool& instance() {
+            static Pool pool;
+            return pool;
+        }
+
+        // Calls task(i) for all i in [0, count), using at most threads
+        // threads (0: all). Rethrows the first exception thrown by a
+        // task. If the pool is busy (e. g. run() is called from within
+        // a task), or if there are more indices than a range can hold,
+        // the calling thread does all the work by itself.
+        template<typename TASK>
+        void run(std::size_t count, unsigned threads, TASK& task) {
+            std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+            const auto available = static_cast<unsigned>(workers_.size()) + 1;
+            if (threads == 0 || threads > available) threads = available;
+            if (count < threads) threads = static_cast<unsigned>(count);
+            if (!busy || threads <= 1 || count > limit) {
+                for (std::size_t i = 0; i < count; ++i) task(i);
+                return;
+            }
+
+            // Hand out the ranges and wake up the workers
+            for (unsigned p = 0; p < threads; ++p) {
+                ranges_[p].bounds.store(pack(count * p / threads, count * (p + 1) / threads));
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                task_ = &task;
+                call_ = [](void* t, std::size_t i) { (*static_cast<TASK*>(t))(i); };
+                participants_ = threads;
+                running_ = threads - 1;
+                error_ = nullptr;
+                ++generation_;
+            }
+            wake_.notify_all();
+
+            // Work along, then wait for the workers
+            work(0);
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return running_ == 0; });
+            task_ = nullptr;
+            if (error_) std::rethrow_exception(error_);
+        }
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& t : workers_) t.join();
+        }
+
+    private:
+        // A range of indices, padded to the size of a cache line, so
+        // that the ranges of two threads are never on the same line.
+        // (Padded rather than aligned: std::vector doesn't honor
+        // alignments beyond std::max_align_t in C++11.)
+        struct Range {
+            std::atomic<std::uint64_t> bounds{0};
+            char padding[64 - sizeof(std::atomic<std::uint64_t>)];
+        };
+
+        // Begin and end are 32 bits each
+        static constexpr std::uint64_t limit = 0xffffffff;
+
+        static std::uint64_t pack(std::size_t begin, std::size_t end) noexcept {
+            assert(begin <= limit && end <= limit);
+            return std::uint64_t(begin) << 32 | std::uint64_t(end);
+        }
+
+        Pool() : ranges_(std::max(1u, std::thread::hardware_concurrency())) {
+            for (std::size_t i = 1; i < ranges_.size(); ++i) {
+                try {
+                    workers_.emplace_back([this, i] { loop(static_cast<unsigned>(i)); });
+                } catch(...) {
+                    break;
+                }
+            }
+        }
+
+        // Worker thread main loop
+        void loop(unsigned self) {
+            std::uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                    if (stop_) return;
+                    seen = generation_;
+                    if (self >= participants_) continue;
+                }
+                work(self);
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (--running_ == 0) done_.notify_all();
+            }
+        }
+
+        // Runs tasks from the own range, then from stolen ones
+        void work(unsigned self) {
+            auto& own = ranges_[self].bounds;
+            for (;;) {
+                // Take the next index from the front of the own range
+                auto b = own.load();
+                while (b >> 32 < (b & 0xffffffff)) {
+                    if (own.compare_exchange_weak(b, b + (std::uint64_t(1) << 32))) {
+                        try {
+                            call_(task_, static_cast<std::size_t>(b >> 32));
+                        } catch(...) {
+                            std::lock_guard<std::mutex> lock(mutex_);
+                            if (!error_) error_ = std::current_exception();
+                        }
+                        b = own.load();
+                    }
+                }
+
+                // Steal the back half of another range
+                auto stolen = false;
+                for (unsigned i = 1; i < participants_ && !stolen; ++i) {
+                    auto& victim = ranges_[(self + i) % participants_].bounds;
+                    auto v = victim.load();
+                    while (v >> 32 < (v & 0xffffffff)) {
+                        const auto begin = v >> 32, end = v & 0xffffffff;
+                        const auto mid = begin + (end - begin) / 2;
+                        if (victim.compare_exchange_weak(v, pack(begin, mid))) {
+                            own.store(pack(mid, end));
+                            stolen = true;
+                            break;
+                        }
+                    }
+                }
+                if (!stolen) return;
+            }
+        }
+
+        std::vector<Range> ranges_;
+        std::vector<std::thread> workers_;
+
+        std::mutex busy_;               // Held by run()
+        std::mutex mutex_;              // Protects the following
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        std::uint64_t generation_ = 0;
+        unsigned participants_ = 0;
+        unsigned running_ = 0;
+        bool stop_ = false;
+        void* task_ = nullptr;
+        void (*call_)(void*, std::size_t) = nullptr;
+        std::exception_ptr error_;
+    };
+
+    // Runs task(i) for all i in [0, count) according to a policy
+    template<typename TASK>
+    void apply(Serial, std::size_t count, TASK& task) {
+        for (std::size_t i = 0; i < count; ++i) task(i);
+    }
+    template<typename TASK>
+    void apply(Parallel policy, std::size_t count, TASK& task) {
+        Pool::instance().run(count, policy.threads, task);
+    }
+
+    /*
+     * Runs a task for every node of a dependency graph on a bounded
+     * number of threads. The calling thread is one of them. A node
+     * is started as soon as all the nodes it depends on are finished,
+     * so the total time is close to the critical path of the graph.
+     *
+     * dependents[i] lists the nodes that depend on node i, pending[i]
+     * is the number of nodes that node i depends on. task(i, ok) runs
+     * node i and returns its success; ok is false if a node that i
+     * depends on failed. Returns the nodes that were never started
+     * because they're part of (or depend on) a cycle.
+     */
+    template<typename TASK>
+    std::vector<std::size_t> schedule(const std::vector<std::vector<std::size_t>>& dependents,
+    std::vector<std::size_t> pending, unsigned threads, TASK task) {
+        const auto count = dependents.size();
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::size_t> ready;
+        std::vector<char> ok(count, 1), done(count, 0);
+        std::size_t running = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (pending[i] == 0) ready.push_back(i);
+        }
+
+        const auto worker = [&] {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                cv.wait(lock, [&] { return !ready.empty() || running == 0; });
+                if (ready.empty()) {
+                    // Nothing to do, and nothing running that could
+                    // make more nodes ready
+                    cv.notify_all();
+                    return;
+                }
+
+                const auto i = ready.back();
+                ready.pop_back();
+                ++running;
+                lock.unlock();
+                const auto success = task(i, ok[i] != 0);
+                lock.lock();
+                --running;
+
+                done[i] = 1;
+                for (const auto d : dependents[i]) {
+                    if (!success) ok[d] = 0;
+                    if (--pending[d] == 0) ready.push_back(d);
+                }
+                cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (unsigned i = 1; i < threads; ++i) {
+            try {
+                pool.emplace_back(worker);
+            } catch(...) {
+                break;
+            }
+        }
+        worker();
+        for (auto& t : pool) {
+            t.join();
+        }
+
+        std::vector<std::size_t> ret;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!done[i]) ret.push_back(i);
+        }
+        return ret;
+    }
+
+    /**
+     * Initialize all plug-ins of one plug-in base class in parallel.
+     *
+     * T is the plug-in base class, threads is the maximum number of
+     * threads to use (0 means one per CPU core).
+     *
+     * Constructs every lazy plug-in and runs the init() hook of every
+     * plug-in class that has a public init() member function. The
+     * plug-ins are processed concurrently on a pool of threads. If a
+     * plug-in was registered with linktimeplugin::after(), the plug-ins
+     * it depends on are initialized before it; independent plug-ins
+     * are initialized at the same time.
+     *
+     * A plug-in is left out of plugins<T>() if its ctor or init()
+     * throws, if one of its dependencies doesn't exist or fails, or if
+     * its dependencies form a cycle. Use RegistrarBase<T>::registrars()
+     * and failed() to find out which plug-ins failed.
+     *
+     * Call this once during startup, before other threads use the
+     * plug-ins. Returns the number of plug-ins that are ready.
+     *
+     * Example:
+     *
+     *      class Plugin : public PluginBase {
+     *      public:
+     *          void init() { ... expensive setup ... }
+     *      };
+     *      REGISTER_PLUGIN(Plugin, "plugin", linktimeplugin::after("tables"));
+     *
+     *      linktimeplugin::initialize<PluginBase>();
+     */
+    template<typename T>
+    std::size_t initialize(unsigned threads = 0) {
+        const Pin pin;
+        const auto registrars = RegistrarBase<T>::registrars();
+        const auto count = registrars.size();
+
+        // Build the dependency graph
+        std::unordered_map<const RegistrarBase<T>*, std::size_t> position;
+        for (std::size_t i = 0; i < count; ++i) {
+            position[registrars[i]] = i;
+        }
+        std::vector<std::vector<std::size_t>> dependents(count);
+        std::vector<std::size_t> pending(count, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            for (const auto key : registrars[i]->after()) {
+                // A dependency that was registered after the view was
+                // taken can't be ordered, so it counts as missing
+                const auto r = RegistrarBase<T>::registrar(key, std::strlen(key));
+                const auto p = r ? position.find(r) : position.end();
+                if (p != position.end()) {
+                    dependents[p->second].push_back(i);
+                    ++pending[i];
+                } else {
+                    registrars[i]->fail();
+                }
+            }
+        }
+
+        // Initialize the plug-ins along the graph
+        std::atomic<std::size_t> ready{0};
+        const auto cycles = schedule(dependents, std::move(pending), threads, [&](std::size_t i, bool ok) {
+            if (!ok) registrars[i]->fail();
+            if (registrars[i]->failed() || !registrars[i]->initialize()) return false;
+            ++ready;
+            return true;
+        });
+        for (const auto i : cycles) {
+            registrars[i]->fail();
+        }
+
+        // Publish the ready set
+        plugins<T>();
+        return ready;
+    }
+
+    /*
+     * Calls fn(slot, p) for every plug-in p of one plug-in base class
+     * according to a policy. The plug-ins are taken from one view of
+     * the registry (see slots()), so the slots are numbered from 0 to
+     * list.size() - 1. If metrics are enabled for the plug-in base
+     * class (see linktimeplugin-metrics.hpp), trace events are
+     * recorded, or the heap use is booked, the view lists the
+     * registrars (so the slots of plug-ins that failed are unused),
+     * and every call is measured.
+     * There are probes around the whole dispatch (see
+     * linktimeplugin-probes.hpp). The caller holds a linktimeplugin::Pin
+     * while it uses the view (see linktimeplugin-epoch.hpp).
+     */
+    template<typename T>
+    Plugins<T> slots(std::false_type) noexcept {
+        return plugins<T>();
+    }
+    template<typename T>
+    View<RegistrarBase<T>> slots(std::true_type) noexcept {
+        plugins<T>();
+        return RegistrarBase<T>::registrars();
+    }
+    template<typename T>
+    auto slots() noexcept -> decltype(slots<T>(metrics::Instrumented<T>())) {
+        return slots<T>(metrics::Instrumented<T>());
+    }
+
+    template<typename T, typename POLICY, typename FN>
+    void visit(POLICY policy, const Plugins<T>& list, FN& fn) {
+        auto task = [&](std::size_t i) { fn(i, list[i]); };
+        apply(policy, list.size(), task);
+    }
+    template<typename T, typename POLICY, typename FN>
+    void visit(POLICY policy, const View<RegistrarBase<T>>& registrars, FN& fn) {
+        auto task = [&](std::size_t i) {
+            const auto r = registrars[i];
+            if (r->failed()) return;
+            if (const auto p = r->get()) {
+                const metrics::Timer<T> timer(*r, i);
+                fn(i, p);
+            }
+        };
+        apply(policy, registrars.size(), task);
+    }
+    template<typename T, typename POLICY, typename LIST, typename FN>
+    void dispatch(POLICY policy, const LIST& list, FN fn) {
+        LINKTIMEPLUGIN_PROBE2(dispatch_start, typeid(T).name(), list.size());
+        visit<T>(policy, list, fn);
+        LINKTIMEPLUGIN_PROBE1(dispatch_done, typeid(T).name());
+    }
+
+    /**
+     * Invoke a function for every plug-in of one plug-in base class.
+     *
+     * T is the plug-in base class, fn is called with a T* for every
+     * plug-in. With linktimeplugin::serial (the default), the plug-ins
+     * are processed one after another in the calling thread. With
+     * linktimeplugin::parallel (or Parallel{n} for at most n threads),
+     * they're processed concurrently on the work-stealing pool, so the
+     * whole broadcast takes about as long as the slowest plug-in.
+     * Returns when fn has returned for all plug-ins; rethrows the
+     * first exception thrown by fn.
+     *
+     * Example:
+     *
+     *      linktimeplugin::for_each<PluginBase>(linktimeplugin::parallel,
+     *          [](PluginBase* p) { p->dosomething(); });
+     */
+    template<typename T, typename POLICY, typename FN>
+    void for_each(POLICY policy, FN fn) {
+        const Pin pin;
+        dispatch<T>(policy, slots<T>(), [&](std::size_t, T* p) { fn(p); });
+    }
+
+    template<typename T, typename FN>
+    void for_each(FN fn) {
+        for_each<T>(serial, fn);
+    }
+
+    /**
+     * Invoke a function for every plug-in of one plug-in base class and
+     * combine the results.
+     *
+     * T is the plug-in base class. map is called with a T* for every
+     * plug-in and returns a result of type R (which must be default
+     * constructible). The results are stored in one slot per plug-in,
+     * so the plug-ins don't need any synchronization among each other,
+     * and then combined as combine(...combine(combine(init, r0), r1)...)
+     * in plug-in order, so the outcome doesn't depend on the policy.
+     *
+     * Example:
+     *
+     *      const auto total = linktimeplugin::reduce<PluginBase>(
+     *          linktimeplugin::parallel, std::size_t(0),
+     *          [](PluginBase* p) { return p->count(); },
+     *          [](std::size_t a, std::size_t b) { return a + b; });
+     */
+    template<typename T, typename POLICY, typename R, typename MAP, typename COMBINE>
+    R reduce(POLICY policy, R init, MAP map, COMBINE combine) {
+        // One slot per plug-in (wrapped, to keep std::vector<bool>
+        // from packing several plug-ins' results into one word)
+        struct Result {
+            R value;
+            bool used;
+        };
+        const Pin pin;
+        const auto list = slots<T>();
+        std::vector<Result> results(list.size());
+        dispatch<T>(policy, list, [&](std::size_t i, T* p) {
+            results[i].value = map(p);
+            results[i].used = true;
+        });
+
+        for (auto& r : results) {
+            if (r.used) init = combine(std::move(init), std::move(r.value));
+        }
+        return init;
+    }
+}
@@ -0,0 +1,189 @@
+/**
+ * @brief Link-time plug-in management: Perfect hash generator
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Scans source files for REGISTER_PLUGIN keys and writes a source
+ * file that defines a minimal perfect hash table over these keys
+ * (linktimeplugin::perfect_hash). Invoked by the
+ * linktimeplugin_perfect_hash() function in linktimeplugin.cmake.
+ *
+ * Usage: linktimeplugin-phf output.cpp source.cpp ...
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <regex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "linktimeplugin.hpp"
+
+namespace {
+    // Key with its hash
+    struct Key {
+        std::string name;
+        std::uint64_t hash;
+    };
+
+    // Returns the keys of all REGISTER_PLUGIN invocations in a file
+    std::set<std::string> scan(const std::string& filename) {
+        std::ifstream in(filename);
+        if (!in) {
+            throw std::runtime_error("Cannot read " + filename);
+        }
+        const std::string text{
+            std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>()
+        };
+
+        static const std::regex re(R"(REGISTER_\w*PLUGIN\s*\(\s*[\w:]+\s*,\s*"([^"\\]*)\")");
+        std::set<std::string> ret;
+        for (std::sregex_iterator it(text.begin(), text.end(), re), end; it != end; ++it) {
+            ret.insert((*it)[1]);
+        }
+        return ret;
+    }
+
+    // Tries to find displacements that move every key to a slot of its
+    // own. Returns false if there are none for this seed.
+    bool build(const std::vector<Key>& keys, linktimeplugin::PerfectHash& table,
+    std::vector<std::array<std::uint32_t, 2>>& displacements, std::vector<int>& slots) {
+        const auto n = table.size;
+
+        // Sort the keys into buckets. PerfectHash::split computes the
+        // bucket and the slot components, so the generator and the
+        // library agree on them by construction.
+        struct Entry {
+            std::uint32_t f1, f2;
+        };
+        std::vector<std::vector<Entry>> buckets(table.buckets);
+        std::vector<std::vector<int>> members(table.buckets);
+        for (std::size_t k = 0; k < keys.size(); ++k) {
+            std::uint32_t b, f1, f2;
+            table.split(keys[k].hash, b, f1, f2);
+            buckets[b].push_back(Entry{f1, f2});
+            members[b].push_back(static_cast<int>(k));
+        }
+
+        // Place the biggest buckets first
+        std::vector<std::size_t> order(table.buckets);
+        for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        displacements.assign(table.buckets, {{0, 0}});
+        slots.assign(n, -1);
+        std::vector<std::size_t> pos;
+        for (const auto b : order) {
+            if (buckets[b].empty()) break;
+
+            auto placed = false;
+            for (std::uint64_t d0 = 0; d0 < n && !placed; ++d0) {
+                for (std::uint64_t d1 = 0; d1 < n && !placed; ++d1) {
+                    pos.clear();
+                    for (const auto& e : buckets[b]) {
+                        const auto p = static_cast<std::size_t>((e.f1 + d0 * e.f2 + d1) % n);
+                        if (slots[p] >= 0 || std::find(pos.begin(), pos.end(), p) != pos.end()) break;
+                        pos.push_back(p);
+                    }
+                    if (pos.size() == buckets[b].size()) {
+                        for (std::size_t i = 0; i < pos.size(); ++i) {
+                            slots[pos[i]] = members[b][i];
+                        }
+                        displacements[b] = {{static_cast<std::uint32_t>(d0), static_cast<std::uint32_t>(d1)}};
+                        placed = true;
+                    }
+                }
+            }
+            if (!placed) return false;
+        }
+        return true;
+    }
+
+    // Writes a string as a C++ string literal
+    std::string literal(const std::string& s) {
+        std::string ret = "\"";
+        for (const auto c : s) {
+            if (c == '"' || c == '\\') ret += '\\';
+            ret += c;
+        }
+        return ret + '"';
+    }
+}
+
+int main(int argc, char** argv) try {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " output.cpp source.cpp ...\n";
+        return EXIT_FAILURE;
+    }
+
+    // Collect the keys of all sources
+    std::set<std::string> names;
+    for (auto i = 2; i < argc; ++i) {
+        const auto keys = scan(argv[i]);
+        names.insert(keys.begin(), keys.end());
+    }
+    std::vector<Key> keys;
+    for (const auto& name : names) {
+        keys.push_back(Key{name, linktimeplugin::hash(name.data(), name.size())});
+    }
+
+    // Find a seed for which all keys can be placed
+    linktimeplugin::PerfectHash table{keys.size(), (keys.size() + 3) / 4, 0, nullptr, nullptr, nullptr};
+    if (table.buckets == 0) table.buckets = 1;
+    std::vector<std::array<std::uint32_t, 2>> displacements(table.buckets, {{0, 0}});
+    std::vector<int> slots;
+    if (!keys.empty()) {
+        while (!build(keys, table, displacements, slots)) {
+            if (++table.seed == 1000) {
+                throw std::runtime_error("Cannot build a perfect hash table (duplicate hash?)");
+            }
+        }
+    }
+
+    // Write the table
+    std::ofstream out(argv[1]);
+    out << "// Generated by linktimeplugin-phf. Do not edit.\n"
+        << "// Minimal perfect hash table over " << keys.size() << " plug-in key(s).\n\n"
+        << "#include \"linktimeplugin.hpp\"\n\n"
+        << "namespace {\n"
+        << "    const std::uint32_t displacements[][2] = {\n";
+    for (const auto& d : displacements) {
+        out << "        {" << d[0] << ", " << d[1] << "},\n";
+    }
+    out << "    };\n\n"
+        << "    const char* const keys[] = {\n";
+    for (const auto k : slots) {
+        out << "        " << literal(keys[k].name) << ",\n";
+    }
+    if (slots.empty()) out << "        nullptr,\n";
+    out << "    };\n\n"
+        << "    const std::size_t lengths[] = {\n";
+    for (const auto k : slots) {
+        out << "        " << keys[k].name.size() << ",\n";
+    }
+    if (slots.empty()) out << "        0,\n";
+    out << "    };\n"
+        << "}\n\n"
+        << "const linktimeplugin::PerfectHash linktimeplugin::perfect_hash = {\n"
+        << "    " << table.size << ", " << table.buckets << ", " << table.seed << "ull,\n"
+        << "    displacements, keys, lengths\n"
+        << "};\n";
+
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot write ") + argv[1]);
+    }
+    return EXIT_SUCCESS;
+} catch(const std::exception& e) {
+    std::cerr << argv[0] << ": " << e.what() << '\n';
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+/**
+ * @brief Link-time plug-in management: USDT probes
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+/**
+ * Static probes for perf, bpftrace, SystemTap, etc.
+ *
+ * If LINKTIMEPLUGIN_USDT is defined (for all translation units that
+ * register or call plug-ins), the library contains SystemTap-compatible
+ * USDT probes of the provider "linktimeplugin". They're defined with
+ * <sys/sdt.h> (e. g. from the systemtap-sdt-dev package); every probe
+ * is a single nop instruction plus a note in the executable, so they
+ * can stay in release builds. Without LINKTIMEPLUGIN_USDT, the probes
+ * and their arguments disappear.
+ *
+ * base is the mangled name of the plug-in base class (typeid().name()),
+ * name is the plug-in class name as given to REGISTER_PLUGIN, key is
+ * the plug-in's key (both nullptr if there's none).
+ *
+ *      registered(base, name, key)             A plug-in was registered
+ *      plugins(base, count)                    plugins() returns count plug-ins
+ *      find(base, key, length, plugin)         find() looked up a key
+ *      dispatch_start(base, count)             for_each()/reduce() start
+ *      dispatch_done(base)                     for_each()/reduce() are done
+ *      call_start(base, name, slot)            A dispatched call starts
+ *      call_done(base, name, slot)             A dispatched call is done
+ *
+ * Example:
+ *
+ *      $ cmake -DLINKTIMEPLUGIN_USDT=ON ..
+ *      $ make
+ *      $ bpftrace -e 'usdt:./demo1:linktimeplugin:registered { printf("%s\n", str(arg1)); }' -c ./demo1
+ */
+
+#ifdef LINKTIMEPLUGIN_USDT
+#include <typeinfo>
+#include <sys/sdt.h>
+
+#define LINKTIMEPLUGIN_PROBE1(name, a) DTRACE_PROBE1(linktimeplugin, name, a)
+#define LINKTIMEPLUGIN_PROBE2(name, a, b) DTRACE_PROBE2(linktimeplugin, name, a, b)
+#define LINKTIMEPLUGIN_PROBE3(name, a, b, c) DTRACE_PROBE3(linktimeplugin, name, a, b, c)
+#define LINKTIMEPLUGIN_PROBE4(name, a, b, c, d) DTRACE_PROBE4(linktimeplugin, name, a, b, c, d)
+#else
+#define LINKTIMEPLUGIN_PROBE1(name, a) ((void)0)
+#define LINKTIMEPLUGIN_PROBE2(name, a, b) ((void)0)
+#define LINKTIMEPLUGIN_PROBE3(name, a, b, c) ((void)0)
+#define LINKTIMEPLUGIN_PROBE4(name, a, b, c, d) ((void)0)
+#endif
+
+namespace linktimeplugin {
+    namespace probes {
+#ifdef LINKTIMEPLUGIN_USDT
+        constexpr bool enabled = true;
+#else
+        constexpr bool enabled = false;
+#endif
+    }
+}
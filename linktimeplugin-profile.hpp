@@ -0,0 +1,187 @@
+/**
+ * @brief Link-time plug-in management: Startup profiling
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+/**
+ * Startup profiling of link-time plug-ins.
+ *
+ * If LINKTIMEPLUGIN_PROFILE is defined (for all translation units that
+ * register plug-ins), every registrar records how long the construction
+ * of its plug-in and the plug-in's init() hook took, along with the
+ * plug-in's class name and the source location of its REGISTER_PLUGIN.
+ * Eager plug-ins are timed during static initialization, lazy plug-ins
+ * when they're constructed on first use.
+ *
+ * linktimeplugin::profile::report() writes the records, slowest first.
+ * If the environment variable LINKTIMEPLUGIN_REPORT is set when the
+ * first plug-in is registered, the report is written to stderr when the
+ * program exits.
+ *
+ * Example:
+ *
+ *      $ cmake -DLINKTIMEPLUGIN_PROFILE=ON ..
+ *      $ make
+ *      $ LINKTIMEPLUGIN_REPORT=1 ./demo1
+ */
+namespace linktimeplugin {
+    namespace profile {
+        /*
+         * What's recorded about one plug-in. Times are in nanoseconds,
+         * -1 if the plug-in hasn't been constructed yet or doesn't have
+         * an init() hook (or it didn't run yet).
+         */
+        struct Record {
+            std::string name;               // Plug-in class name
+            const char* file;               // Source location of the registration
+            int line;
+            bool lazy;                      // Constructed on first use?
+            std::int64_t constructed;       // When the construction started
+            std::int64_t construction;      // Duration of the construction
+            std::int64_t init;              // Duration of the init() hook
+
+            // Returns the total time spent on this plug-in
+            std::int64_t total() const noexcept {
+                return std::max<std::int64_t>(construction, 0) + std::max<std::int64_t>(init, 0);
+            }
+        };
+
+        // Returns the current time in nanoseconds
+        inline std::int64_t now() noexcept {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        // The records of all plug-ins (of all plug-in base classes), in
+        // order of registration, and the mutex that protects them. They
+        // are never freed, so that they can be reported after
+        // the registrars are destroyed. A deque, so that the registrars
+        // can keep pointers to their records.
+        inline std::deque<Record>& records() noexcept {
+            static const auto ret = new std::deque<Record>;
+            return *ret;
+        }
+        inline std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        /**
+         * Write the startup report: One line per plug-in, slowest first,
+         * with the times in microseconds. The start time is relative to
+         * the first plug-in construction.
+         */
+        inline void report(std::ostream& os) {
+            std::vector<Record> r;
+            {
+                std::lock_guard<std::mutex> lock(mutex());
+                r.assign(records().begin(), records().end());
+            }
+            std::stable_sort(r.begin(), r.end(), [](const Record& a, const Record& b) {
+                return a.total() > b.total();
+            });
+
+            // Total time, and when the first construction started
+            std::int64_t total = 0, first = -1;
+            for (const auto& e : r) {
+                total += e.total();
+                if (e.constructed >= 0 && (first < 0 || e.constructed < first)) first = e.constructed;
+            }
+
+            const auto us = [](std::int64_t ns) {
+                std::ostringstream ret;
+                if (ns < 0) {
+                    ret << '-';
+                } else {
+                    ret << std::fixed << std::setprecision(1) << static_cast<double>(ns) / 1e3;
+                }
+                return ret.str();
+            };
+
+            os << "Plug-in startup report: " << r.size() << " plug-ins, "
+                << us(total) << " us\n"
+                << std::setw(10) << "start us" << std::setw(12) << "total us" << std::setw(14) << "construct us"
+                << std::setw(10) << "init us" << "  plug-in\n";
+            for (const auto& e : r) {
+                os << std::setw(10) << us(e.constructed < 0 ? -1 : e.constructed - first)
+                    << std::setw(12) << us(e.total())
+                    << std::setw(14) << us(e.construction)
+                    << std::setw(10) << us(e.init)
+                    << "  " << e.name;
+                if (e.file) os << " (" << e.file << ':' << e.line << ')';
+                if (e.lazy) os << (e.construction < 0 ? " lazy, not constructed" : " lazy");
+                os << '\n';
+            }
+        }
+
+        /**
+         * Write the startup report to stderr when the program exits.
+         */
+        inline void report_at_exit() noexcept {
+            std::atexit([] { report(std::cerr); });
+        }
+
+        // Returns the name of a type
+        inline std::string name(const std::type_info& type) {
+#ifdef __GNUG__
+            auto status = 0;
+            std::unique_ptr<char, void(*)(void*)> ret(
+                abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), std::free);
+            if (status == 0 && ret) return ret.get();
+#endif
+            return type.name();
+        }
+
+        // Adds the record of a plug-in. name is the plug-in class name
+        // as written in REGISTER_PLUGIN or nullptr, type is the plug-in
+        // class, start and end are the times of the plug-in's
+        // construction (-1 for lazy plug-ins). Called by the registrar.
+        // Returns nullptr if there's not enough memory.
+        inline Record* add(const char* name, const std::type_info& type, const char* file, int line,
+        bool lazy, std::int64_t start, std::int64_t end) noexcept {
+            try {
+                Record record{name ? name : profile::name(type), file, line, lazy,
+                    start, start < 0 ? -1 : end - start, -1};
+                std::lock_guard<std::mutex> lock(mutex());
+                if (records().empty() && std::getenv("LINKTIMEPLUGIN_REPORT")) {
+                    report_at_exit();
+                }
+                records().push_back(std::move(record));
+                return &records().back();
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        // Records the duration of a plug-in's construction or of its
+        // init() hook. Called by the registrar.
+        inline void set(Record* record, std::int64_t Record::* what, std::int64_t start, std::int64_t end) noexcept {
+            if (!record) return;
+            std::lock_guard<std::mutex> lock(mutex());
+            if (what == &Record::construction) record->constructed = start;
+            record->*what = end - start;
+        }
+    }
+}
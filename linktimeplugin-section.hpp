@@ -0,0 +1,209 @@
+/**
+ * @brief Link-time plug-in management: Linker section registration
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+/**
+ * Registration of link-time plug-ins through a linker section.
+ *
+ * REGISTER_SECTION_PLUGIN works like REGISTER_PLUGIN, but instead of
+ * creating a registrar object, it places a descriptor of the plug-in
+ * into the "linktimeplugin" section of the object file. The linker
+ * collects the descriptors of all object files into one array and
+ * defines the symbols __start_linktimeplugin and __stop_linktimeplugin
+ * around it. The descriptors are constant-initialized, so registration
+ * takes no time at startup, needs no heap, and cannot fail. The plug-in
+ * instance itself is constructed when it's used for the first time.
+ *
+ * Section names can't be derived from a type, so the descriptors of
+ * all plug-in base classes share one section, and every descriptor
+ * records which base class it belongs to.
+ *
+ * Requires a linker that defines __start_/__stop_ symbols for sections
+ * whose names are valid C identifiers (GNU ld, gold, lld on ELF
+ * platforms).
+ *
+ * Example:
+ *
+ *      // In the plug-in cpp file:
+ *      REGISTER_SECTION_PLUGIN(Plugin, "plugin");
+ *
+ *      // In the application:
+ *      for (const auto p : linktimeplugin::section::plugins<PluginBase>()) {
+ *          p->dosomething();
+ *      }
+ */
+namespace linktimeplugin {
+    namespace section {
+        /*
+         * Descriptor of one plug-in class. base identifies the plug-in
+         * base class, get returns the plug-in instance (as a pointer
+         * to the plug-in base class), key is the plug-in's key or
+         * nullptr.
+         */
+        struct Descriptor {
+            const void* base;
+            void* (*get)();
+            const char* key;
+        };
+
+        // Identifies a plug-in base class by the address of id
+        template<typename BASE>
+        struct Tag {
+            static const char id;
+        };
+        template<typename BASE>
+        const char Tag<BASE>::id = 0;
+
+        // Returns the instance of a plug-in class, constructing it on
+        // first use. For plug-in classes with constexpr ctors, the
+        // compiler constant-initializes the instance, too.
+        template<typename PLUGIN>
+        void* get() {
+            static PLUGIN plugin;
+            return static_cast<typename PLUGIN::Base*>(&plugin);
+        }
+    }
+}
+
+// Boundaries of the descriptor array, defined by the linker. Weak, so
+// that a program without any section plug-ins still links.
+extern "C" {
+    extern const linktimeplugin::section::Descriptor __start_linktimeplugin[] __attribute__((weak));
+    extern const linktimeplugin::section::Descriptor __stop_linktimeplugin[] __attribute__((weak));
+}
+
+namespace linktimeplugin {
+    namespace section {
+        /*
+         * The plug-ins of one plug-in base class: A range of pointers
+         * to the plug-in instances. Iterating it walks the descriptor
+         * array and skips the descriptors of other base classes.
+         */
+        template<typename BASE>
+        class Plugins {
+        public:
+            class const_iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = BASE*;
+                using difference_type = std::ptrdiff_t;
+                using pointer = BASE* const*;
+                using reference = BASE*;
+
+                const_iterator(const Descriptor* d, const Descriptor* end) noexcept
+                : d_(d), end_(end) {
+                    skip();
+                }
+
+                BASE* operator*() const {
+                    return static_cast<BASE*>(d_->get());
+                }
+
+                // Returns the descriptor the iterator points to
+                const Descriptor& descriptor() const noexcept {
+                    return *d_;
+                }
+
+                const_iterator& operator++() noexcept {
+                    ++d_;
+                    skip();
+                    return *this;
+                }
+                const_iterator operator++(int) noexcept {
+                    auto ret = *this;
+                    ++*this;
+                    return ret;
+                }
+
+                bool operator==(const const_iterator& that) const noexcept { return d_ == that.d_; }
+                bool operator!=(const const_iterator& that) const noexcept { return d_ != that.d_; }
+
+            private:
+                void skip() noexcept {
+                    while (d_ != end_ && d_->base != &Tag<BASE>::id) ++d_;
+                }
+
+                const Descriptor* d_;
+                const Descriptor* end_;
+            };
+            using iterator = const_iterator;
+
+            const_iterator begin() const noexcept {
+                return const_iterator(__start_linktimeplugin, __stop_linktimeplugin);
+            }
+            const_iterator end() const noexcept {
+                return const_iterator(__stop_linktimeplugin, __stop_linktimeplugin);
+            }
+            bool empty() const noexcept {
+                return begin() == end();
+            }
+        };
+
+        /**
+         * Get pointers to instances of all plug-in classes of one
+         * plug-in base class that were registered with
+         * REGISTER_SECTION_PLUGIN.
+         *
+         * T is the plug-in base class.
+         */
+        template<typename T>
+        Plugins<T> plugins() noexcept {
+            return Plugins<T>();
+        }
+
+        /**
+         * Get the plug-in that was registered with the given key with
+         * REGISTER_SECTION_PLUGIN, or nullptr. This compares the key
+         * with every descriptor's key.
+         *
+         * T is the plug-in base class.
+         */
+        template<typename T>
+        T* find(const char* key) {
+            const auto range = plugins<T>();
+            for (auto it = range.begin(); it != range.end(); ++it) {
+                const auto k = it.descriptor().key;
+                if (k && std::strcmp(k, key) == 0) {
+                    return *it;
+                }
+            }
+            return nullptr;
+        }
+    }
+}
+
+/**
+ * Register one plug-in class through the linker section.
+ *
+ * x is the name of the derived plug-in class. An optional second
+ * argument is a string literal that serves as the plug-in's key
+ * for linktimeplugin::section::find().
+ *
+ * Example:
+ *
+ *      REGISTER_SECTION_PLUGIN(Plugin, "plugin");
+ */
+#define REGISTER_SECTION_PLUGIN(...) LINKTIMEPLUGIN_SECTION_EXPAND( \
+    LINKTIMEPLUGIN_SECTION_REGISTER(__VA_ARGS__, nullptr, ~))
+
+// Helpers for REGISTER_SECTION_PLUGIN. The descriptor is aligned to
+// the size of a pointer, which is its natural alignment (it consists of
+// pointers), so that the linker packs the descriptors without gaps,
+// like the elements of an array.
+#define LINKTIMEPLUGIN_SECTION_EXPAND(x) x
+#define LINKTIMEPLUGIN_SECTION_REGISTER(x, key, ...) \
+    __attribute__((used, section("linktimeplugin"), aligned(sizeof(void*)))) \
+    static const linktimeplugin::section::Descriptor x##descriptor = { \
+        &linktimeplugin::section::Tag<x::Base>::id, \
+        &linktimeplugin::section::get<x>, \
+        key \
+    }
@@ -0,0 +1,314 @@
+/**
+ * @brief Link-time plug-in management: Trace events
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+#include "linktimeplugin-profile.hpp"
+
+#ifndef LINKTIMEPLUGIN_TRACE_EVENTS
+#define LINKTIMEPLUGIN_TRACE_EVENTS 16384
+#endif
+
+/**
+ * Trace events of link-time plug-ins.
+ *
+ * If LINKTIMEPLUGIN_TRACE is defined (for all translation units that
+ * register or call plug-ins), the library records the registration,
+ * construction, and init() hook of every plug-in, and every call of a
+ * plug-in through the dispatch helpers (linktimeplugin::for_each() and
+ * reduce() in linktimeplugin-parallel.hpp), as trace events.
+ *
+ * Every thread records its events into a ring buffer of its own
+ * (LINKTIMEPLUGIN_TRACE_EVENTS events; when it's full, the oldest
+ * events are overwritten), without locking. linktimeplugin::trace::
+ * flush() writes the events of all threads to a file in the Trace
+ * Event Format of Chrome and Perfetto (open it in chrome://tracing or
+ * https://ui.perfetto.dev). If the environment variable
+ * LINKTIMEPLUGIN_TRACE_FILE is set when the first event is recorded,
+ * the events are written to that file when the program exits.
+ *
+ * Example:
+ *
+ *      $ cmake -DLINKTIMEPLUGIN_TRACE=ON ..
+ *      $ make
+ *      $ LINKTIMEPLUGIN_TRACE_FILE=trace.json ./demo1
+ */
+namespace linktimeplugin {
+    namespace trace {
+#ifdef LINKTIMEPLUGIN_TRACE
+        constexpr bool enabled = true;
+#else
+        constexpr bool enabled = false;
+#endif
+
+        /*
+         * One event. Times are in nanoseconds (see profile::now()),
+         * instant events have a duration of -1. All strings have static
+         * storage duration.
+         */
+        struct Event {
+            const char* category;
+            const char* name;           // Plug-in name
+            const char* base;           // Plug-in base class name
+            std::int64_t start;
+            std::int64_t duration;
+        };
+
+        /*
+         * One event in a ring buffer, guarded by a sequence lock: The
+         * owning thread sets sequence to 0 while it writes the event,
+         * and to the event's number + 1 when it's done. A reader that
+         * doesn't see the same number before and after copying the
+         * event drops it, since it was being written or overwritten.
+         */
+        struct Slot {
+            std::atomic<std::uint64_t> sequence{0};
+            std::atomic<const char*> category{nullptr};
+            std::atomic<const char*> name{nullptr};
+            std::atomic<const char*> base{nullptr};
+            std::atomic<std::int64_t> start{0};
+            std::atomic<std::int64_t> duration{0};
+
+            // Writes event number n. Called by the owning thread only.
+            void write(std::uint64_t n, const Event& e) noexcept {
+                sequence.store(0, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                category.store(e.category, std::memory_order_relaxed);
+                name.store(e.name, std::memory_order_relaxed);
+                base.store(e.base, std::memory_order_relaxed);
+                start.store(e.start, std::memory_order_relaxed);
+                duration.store(e.duration, std::memory_order_relaxed);
+                sequence.store(n + 1, std::memory_order_release);
+            }
+
+            // Reads event number n. Returns false if the slot doesn't
+            // hold it (anymore), or if it's being written.
+            bool read(std::uint64_t n, Event& e) const noexcept {
+                if (sequence.load(std::memory_order_acquire) != n + 1) return false;
+                e = Event{category.load(std::memory_order_relaxed), name.load(std::memory_order_relaxed),
+                    base.load(std::memory_order_relaxed), start.load(std::memory_order_relaxed),
+                    duration.load(std::memory_order_relaxed)};
+                std::atomic_thread_fence(std::memory_order_acquire);
+                return sequence.load(std::memory_order_relaxed) == n + 1;
+            }
+        };
+
+        /*
+         * Ring buffer of the events of one thread. Only the owning
+         * thread writes it; head is the number of events written so
+         * far, so the buffer holds the events [head - size, head).
+         */
+        struct Ring {
+            static constexpr std::size_t size = LINKTIMEPLUGIN_TRACE_EVENTS;
+            static_assert((size & (size - 1)) == 0, "LINKTIMEPLUGIN_TRACE_EVENTS must be a power of two");
+
+            Slot slots[size];
+            std::atomic<std::uint64_t> head{0};
+            unsigned thread;
+
+            // The head at the last flush(), and whether the owning
+            // thread has ended (both changed under the mutex)
+            std::uint64_t flushed = 0;
+            bool ended = false;
+        };
+
+        // The ring buffers of all threads, and the mutex that protects
+        // the list. The list is never freed, so that threads can record
+        // until the program ends. The ring of a thread that ended is
+        // freed once its events are written (see flush()).
+        inline std::vector<Ring*>& rings() noexcept {
+            static const auto ret = new std::vector<Ring*>;
+            return *ret;
+        }
+        inline std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // Writes a JSON string
+        inline void quote(std::FILE* f, const char* s) {
+            std::fputc('"', f);
+            for (; s && *s; ++s) {
+                if (*s == '"' || *s == '\\') std::fputc('\\', f);
+                if (static_cast<unsigned char>(*s) >= 0x20) std::fputc(*s, f);
+            }
+            std::fputc('"', f);
+        }
+
+        /**
+         * Write the recorded events of all threads to a file, as a JSON
+         * trace. Returns false if the file couldn't be written. Events
+         * that threads record at the same time may be missing. The
+         * events of threads that ended are written by the first flush()
+         * after they ended only.
+         */
+        inline bool flush(const char* path) {
+            // Copy the events of every thread, leaving out the ones
+            // that are written or overwritten while copying, and free
+            // the rings of the threads that ended
+            struct Copy {
+                unsigned thread;
+                std::vector<Event> events;
+            };
+            std::vector<Copy> copies;
+            {
+                std::lock_guard<std::mutex> lock(mutex());
+                auto& all = rings();
+                std::size_t kept = 0;
+                for (std::size_t k = 0; k < all.size(); ++k) {
+                    const auto r = all[k];
+                    const auto head = r->head.load(std::memory_order_acquire);
+                    const auto first = head > Ring::size ? head - Ring::size : 0;
+                    Copy c{r->thread, {}};
+                    c.events.reserve(static_cast<std::size_t>(head - first));
+                    for (auto i = first; i < head; ++i) {
+                        Event e;
+                        if (r->slots[i & (Ring::size - 1)].read(i, e)) c.events.push_back(e);
+                    }
+                    copies.push_back(std::move(c));
+
+                    r->flushed = head;
+                    if (r->ended) {
+                        delete r;
+                    } else {
+                        all[kept++] = r;
+                    }
+                }
+                all.resize(kept);
+            }
+
+            // Times are relative to the first event
+            auto origin = INT64_MAX;
+            for (const auto& c : copies) {
+                for (const auto& e : c.events) origin = std::min(origin, e.start);
+            }
+
+            const std::unique_ptr<std::FILE, int(*)(std::FILE*)> f(std::fopen(path, "w"), std::fclose);
+            if (!f) return false;
+            std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f.get());
+            auto first = true;
+            for (const auto& c : copies) {
+                for (const auto& e : c.events) {
+                    std::fputs(first ? "\n{\"name\":" : ",\n{\"name\":", f.get());
+                    first = false;
+                    quote(f.get(), e.name);
+                    std::fputs(",\"cat\":", f.get());
+                    quote(f.get(), e.category);
+                    std::fprintf(f.get(), ",\"ph\":\"%s\",\"ts\":%.3f", e.duration < 0 ? "i" : "X",
+                        static_cast<double>(e.start - origin) / 1e3);
+                    if (e.duration >= 0) {
+                        std::fprintf(f.get(), ",\"dur\":%.3f", static_cast<double>(e.duration) / 1e3);
+                    } else {
+                        std::fputs(",\"s\":\"t\"", f.get());
+                    }
+                    std::fprintf(f.get(), ",\"pid\":1,\"tid\":%u,\"args\":{\"base\":", c.thread);
+                    quote(f.get(), e.base);
+                    std::fputs("}}", f.get());
+                }
+            }
+            std::fputs("\n]}\n", f.get());
+            return std::ferror(f.get()) == 0;
+        }
+
+        /*
+         * The ring buffer of one thread. When the thread ends, the ring
+         * is freed at once if all its events were written already, and
+         * by the next flush() if not.
+         */
+        struct Owner {
+            Ring* ring = nullptr;
+
+            ~Owner() {
+                closed() = true;
+                if (!ring) return;
+                std::lock_guard<std::mutex> lock(mutex());
+                if (ring->head.load(std::memory_order_relaxed) != ring->flushed) {
+                    ring->ended = true;
+                    return;
+                }
+                auto& all = rings();
+                all.erase(std::find(all.begin(), all.end(), ring));
+                delete ring;
+            }
+
+            // Tells if the calling thread's ring is gone (which happens
+            // when the thread ends). Events recorded afterwards are lost.
+            static bool& closed() noexcept {
+                static thread_local bool ret = false;
+                return ret;
+            }
+        };
+
+        // Returns the ring buffer of the calling thread, or nullptr if
+        // there's not enough memory or the thread is ending
+        inline Ring* ring() noexcept {
+            if (Owner::closed()) return nullptr;
+            static thread_local Owner owner;
+            if (!owner.ring) {
+                try {
+                    std::unique_ptr<Ring> r(new Ring);
+                    std::lock_guard<std::mutex> lock(mutex());
+                    static unsigned threads = 0;
+                    if (threads == 0) {
+                        if (const auto path = std::getenv("LINKTIMEPLUGIN_TRACE_FILE")) {
+                            static std::string file;
+                            file = path;
+                            std::atexit([] { flush(file.c_str()); });
+                        }
+                    }
+                    r->thread = threads++;
+                    rings().push_back(r.get());
+                    owner.ring = r.release();
+                } catch(...) {}
+            }
+            return owner.ring;
+        }
+
+        // Records an event in the calling thread's ring buffer
+        inline void record(const Event& e) noexcept {
+            if (const auto r = ring()) {
+                const auto head = r->head.load(std::memory_order_relaxed);
+                r->slots[head & (Ring::size - 1)].write(head, e);
+                r->head.store(head + 1, std::memory_order_release);
+            }
+        }
+
+        // Records an event that happened at one point in time
+        inline void instant(const char* category, const char* name, const char* base) noexcept {
+            record(Event{category, name, base, profile::now(), -1});
+        }
+
+        // Records an event that took some time
+        inline void complete(const char* category, const char* name, const char* base,
+        std::int64_t start, std::int64_t end) noexcept {
+            record(Event{category, name, base, start, end - start});
+        }
+
+        // Returns the name of a type, with static storage duration
+        template<typename T>
+        const char* name() noexcept {
+            static const std::string* ret = [] {
+                try {
+                    return new std::string(profile::name(typeid(T)));
+                } catch(...) {
+                    return static_cast<std::string*>(nullptr);
+                }
+            }();
+            return ret ? ret->c_str() : typeid(T).name();
+        }
+    }
+}
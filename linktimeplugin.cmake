@@ -0,0 +1,68 @@
+# Link-time plug-ins
+# CMake helper functions
+# by agent 2026-10-16
+
+# Directory of this file (and of linktimeplugin.hpp)
+set(LINKTIMEPLUGIN_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+# Generate a minimal perfect hash table over the plug-in keys of a
+# target. Scans the target's sources for REGISTER_PLUGIN(x, "key") at
+# build time, compiles the generated table into the target, and makes
+# linktimeplugin::find() use it for these keys. Keys that aren't found
+# in the sources still work; they're looked up in the regular index.
+#
+# Usage: linktimeplugin_perfect_hash(target)
+function(linktimeplugin_perfect_hash target)
+    # The generator program, built once per project
+    if(NOT TARGET linktimeplugin-phf)
+        add_executable(linktimeplugin-phf ${LINKTIMEPLUGIN_DIR}/linktimeplugin-phf.cpp)
+        target_include_directories(linktimeplugin-phf PRIVATE ${LINKTIMEPLUGIN_DIR})
+    endif()
+
+    # The target's sources, with absolute paths
+    get_target_property(sources ${target} SOURCES)
+    set(inputs)
+    foreach(source ${sources})
+        get_filename_component(source ${source} ABSOLUTE)
+        list(APPEND inputs ${source})
+    endforeach()
+
+    set(output ${CMAKE_CURRENT_BINARY_DIR}/${target}-perfect-hash.cpp)
+    add_custom_command(
+        OUTPUT ${output}
+        COMMAND linktimeplugin-phf ${output} ${inputs}
+        DEPENDS linktimeplugin-phf ${inputs}
+        COMMENT "Generating plug-in key perfect hash table for ${target}"
+        VERBATIM
+    )
+
+    target_sources(${target} PRIVATE ${output})
+    target_include_directories(${target} PRIVATE ${LINKTIMEPLUGIN_DIR})
+    target_compile_definitions(${target} PRIVATE LINKTIMEPLUGIN_PERFECT_HASH)
+endfunction()
+
+# Write a report of the static footprint of every plug-in that's
+# registered in a target (the size of its registrar object, which holds
+# the plug-in object) to <target>-footprint.txt whenever the target is
+# linked. Reads the target's symbol table with nm, so the target mustn't
+# be stripped. Use linktimeplugin::budget() to limit the footprint of a
+# plug-in at compile time; the budget leaves out the registrar's own
+# members (see linktimeplugin-footprint.cmake).
+#
+# Usage: linktimeplugin_footprint(target)
+function(linktimeplugin_footprint target)
+    if(NOT CMAKE_NM)
+        message(WARNING "nm not found, no plug-in footprint report for ${target}")
+        return()
+    endif()
+
+    add_custom_command(
+        TARGET ${target} POST_BUILD
+        COMMAND ${CMAKE_COMMAND}
+            -DNM=${CMAKE_NM}
+            -DBINARY=$<TARGET_FILE:${target}>
+            -DOUTPUT=${CMAKE_CURRENT_BINARY_DIR}/${target}-footprint.txt
+            -P ${LINKTIMEPLUGIN_DIR}/linktimeplugin-footprint.cmake
+        VERBATIM
+    )
+endfunction()
@@ -8,8 +8,35 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "linktimeplugin-epoch.hpp"
+#include "linktimeplugin-probes.hpp"
+#ifdef LINKTIMEPLUGIN_PROFILE
+#include "linktimeplugin-profile.hpp"
+#endif
+#ifdef LINKTIMEPLUGIN_TRACE
+#include "linktimeplugin-trace.hpp"
+#endif
+#ifdef LINKTIMEPLUGIN_HEAP
+#include "linktimeplugin-heap.hpp"
+#endif
+
+// Set if the registrars measure the construction of their plug-ins
+#if defined(LINKTIMEPLUGIN_PROFILE) || defined(LINKTIMEPLUGIN_TRACE)
+#define LINKTIMEPLUGIN_TIMING
+#endif
 
 /**
  * Link-time plug-in management.
@@ -24,9 +51,406 @@
  *     name of the derived plug-in class.
  *  5. To retrieve a list of all plug-ins, invoke linktimeplugin::plugins<x>(),
  *     where x is the name of the plug-in base class. This function
- *     returns a pointer to an instance of every plug-in class.
+ *     returns a view of pointers to an instance of every plug-in class.
+ *  6. Optionally, give a plug-in a key with REGISTER_PLUGIN(x, "key")
+ *     and look it up with linktimeplugin::find<x>("key").
+ *  7. Optionally, use REGISTER_LAZY_PLUGIN instead of REGISTER_PLUGIN
+ *     to construct the plug-in instance on first use only, or
+ *     REGISTER_ARENA_PLUGIN to construct it on first use in a block
+ *     together with the others (see linktimeplugin-arena.hpp), or
+ *     REGISTER_LOCAL_PLUGIN to give every thread an instance of its
+ *     own (see linktimeplugin-local.hpp), or REGISTER_FACTORY_PLUGIN
+ *     to create any number of recycled instances on demand (see
+ *     linktimeplugin-factory.hpp).
+ *  8. Optionally, declare the keys of the plug-ins that a plug-in
+ *     depends on with REGISTER_PLUGIN(x, "key", linktimeplugin::after(...)).
+ *  9. Optionally, limit the size of a plug-in with
+ *     REGISTER_PLUGIN(x, linktimeplugin::budget<bytes>()), and describe
+ *     it with REGISTER_PLUGIN(x, linktimeplugin::meta("name", version,
+ *     priority, flags)), which the registrars return (see
+ *     RegistrarBase::registrars()) without constructing the plug-in.
+ * 10. Optionally, call linktimeplugin::freeze<x>() once all plug-ins are
+ *     registered to compact the registry into a read-only table.
+ *     Plug-ins can be registered and unregistered (by destroying their
+ *     registrars) at any time from any thread; readers that run at the
+ *     same time hold a linktimeplugin::Pin while they use the views and
+ *     plug-ins that plugins() and find() return (see
+ *     linktimeplugin-epoch.hpp).
+ * 11. Optionally, define LINKTIMEPLUGIN_PROFILE to record how long the
+ *     construction of every plug-in takes (see linktimeplugin-profile.hpp),
+ *     or LINKTIMEPLUGIN_TRACE to record trace events of the plug-ins (see
+ *     linktimeplugin-trace.hpp), or LINKTIMEPLUGIN_USDT for static probes
+ *     (see linktimeplugin-probes.hpp), or LINKTIMEPLUGIN_HEAP to book the
+ *     heap use of every plug-in (see linktimeplugin-heap.hpp).
  */
 namespace linktimeplugin {
+    /*
+     * Hash function for plug-in keys (64-bit FNV-1a).
+     */
+    inline std::uint64_t hash(const char* key, std::size_t length) noexcept {
+        std::uint64_t h = 14695981039346656037ull;
+        for (std::size_t i = 0; i < length; ++i) {
+            h ^= static_cast<unsigned char>(key[i]);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    /*
+     * Minimal perfect hash table over the plug-in keys of one
+     * executable. The table is generated at build time by the
+     * linktimeplugin_perfect_hash() function in linktimeplugin.cmake,
+     * which scans the executable's sources for REGISTER_PLUGIN keys.
+     * It uses the hash-and-displace scheme: The key hash selects a
+     * bucket, and the bucket's displacement pair moves the key to a
+     * slot of its own.
+     */
+    struct PerfectHash {
+        std::size_t size;                           // Number of keys
+        std::size_t buckets;                        // Number of buckets
+        std::uint64_t seed;                         // Hash seed
+        const std::uint32_t (*displacements)[2];    // One pair per bucket
+        const char* const* keys;                    // One key per slot
+        const std::size_t* lengths;                 // Key lengths
+
+        // Splits a key hash into the bucket number and the two
+        // components of the slot number.
+        void split(std::uint64_t h, std::uint32_t& bucket, std::uint32_t& f1, std::uint32_t& f2) const noexcept {
+            std::uint64_t g = h ^ seed;
+            g = (g ^ (g >> 30)) * 0xbf58476d1ce4e5b9ull;
+            g = (g ^ (g >> 27)) * 0x94d049bb133111ebull;
+            g ^= g >> 31;
+            bucket = static_cast<std::uint32_t>(g >> 32) % buckets;
+            f1 = static_cast<std::uint32_t>(g) % size;
+            f2 = static_cast<std::uint32_t>((g * 0x9e3779b97f4a7c15ull) >> 32) % size;
+        }
+
+        // Returns the slot of a key hash (only meaningful if the key
+        // is in the table).
+        std::size_t slot(std::uint64_t h) const noexcept {
+            std::uint32_t bucket, f1, f2;
+            split(h, bucket, f1, f2);
+            const auto& d = displacements[bucket];
+            return static_cast<std::size_t>((f1 + std::uint64_t(d[0]) * f2 + d[1]) % size);
+        }
+
+        // Returns the slot of a key, or size if the key isn't in the
+        // table. This is one hash (computed by the caller) and one
+        // string comparison.
+        std::size_t find(const char* key, std::size_t length, std::uint64_t h) const noexcept {
+            if (size == 0) return size;
+            const auto s = slot(h);
+            return lengths[s] == length && std::memcmp(keys[s], key, length) == 0 ? s : size;
+        }
+    };
+
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+    // Defined in the source file generated by linktimeplugin_perfect_hash()
+    extern const PerfectHash perfect_hash;
+#endif
+
+    /*
+     * Read-only view of a list of pointers, e. g. of the plug-ins of
+     * one plug-in base class. This is a pointer and a size that refer
+     * to the registry's snapshot, so copying or iterating it costs no
+     * allocation and no virtual call. The view remains valid until
+     * the registry changes (a plug-in is registered, unregistered, or
+     * fails). If other threads may change the registry, hold a
+     * linktimeplugin::Pin while using the view; it stays valid until
+     * the pin is released.
+     */
+    template<typename T>
+    class View {
+    public:
+        using value_type = T*;
+        using size_type = std::size_t;
+        using const_iterator = T* const*;
+        using iterator = const_iterator;
+
+        View() noexcept = default;
+        View(const_iterator begin, size_type size) noexcept
+        : begin_(begin), size_(size) {}
+
+        const_iterator begin() const noexcept { return begin_; }
+        const_iterator end() const noexcept { return begin_ + size_; }
+        size_type size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+        T* operator[](size_type i) const noexcept { return begin_[i]; }
+
+    private:
+        const_iterator begin_ = nullptr;
+        size_type size_ = 0;
+    };
+
+    // View of the plug-ins of one plug-in base class
+    template<typename BASE>
+    using Plugins = View<BASE>;
+
+    /*
+     * Registration option: Keys of the plug-ins that a plug-in depends
+     * on. linktimeplugin::initialize() initializes these first.
+     */
+    template<std::size_t N>
+    struct After {
+        const char* keys[N];
+    };
+    template<>
+    struct After<0> {};
+
+    /**
+     * Declare the dependencies of a plug-in. The arguments are the keys
+     * of other plug-ins of the same plug-in base class.
+     *
+     * Example:
+     *
+     *      REGISTER_PLUGIN(Parser, "parser", linktimeplugin::after("tables"));
+     */
+    template<typename... KEYS>
+    constexpr After<sizeof...(KEYS)> after(KEYS... keys) noexcept {
+        return After<sizeof...(KEYS)>{{keys...}};
+    }
+    constexpr After<0> after() noexcept {
+        return After<0>();
+    }
+
+    /*
+     * Registration option: The plug-in class name and the source
+     * location of the registration. Passed by REGISTER_PLUGIN.
+     */
+    struct Site {
+        const char* name;
+        const char* file;
+        int line;
+    };
+
+    /*
+     * Registration option: The most bytes that the plug-in may add to
+     * the static data of the executable. Checked at compile time.
+     */
+    template<std::size_t BYTES>
+    struct Budget {
+        static constexpr std::size_t bytes = BYTES;
+    };
+
+    /**
+     * Limit the static footprint of a plug-in: The plug-in object and
+     * the padding that its alignment adds to its registrar. Compilation
+     * fails if the plug-in class doesn't fit.
+     *
+     * Example:
+     *
+     *      REGISTER_PLUGIN(Parser, "parser", linktimeplugin::budget<256>());
+     */
+    template<std::size_t BYTES>
+    constexpr Budget<BYTES> budget() noexcept {
+        return Budget<BYTES>();
+    }
+
+    template<typename... OPTIONS>
+    struct Options;
+
+    // The smallest budget among the (decayed) registration options
+    // (SIZE_MAX if there's none)
+    template<typename... OPTIONS>
+    struct Limit : std::integral_constant<std::size_t, SIZE_MAX> {};
+    template<typename OPTION, typename... OPTIONS>
+    struct Limit<OPTION, OPTIONS...> : Limit<OPTIONS...> {};
+    template<std::size_t BYTES, typename... OPTIONS>
+    struct Limit<Budget<BYTES>, OPTIONS...> : std::integral_constant<std::size_t,
+        (BYTES < Limit<OPTIONS...>::value ? BYTES : Limit<OPTIONS...>::value)> {};
+    template<typename... INNER, typename... OPTIONS>
+    struct Limit<Options<INNER...>, OPTIONS...> : Limit<INNER..., OPTIONS...> {};
+
+    // Tells if a registration option is among the (decayed) options
+    template<typename OPTION, typename... OPTIONS>
+    struct Has : std::false_type {};
+    template<typename OPTION, typename FIRST, typename... OPTIONS>
+    struct Has<OPTION, FIRST, OPTIONS...> : std::integral_constant<bool,
+        std::is_same<OPTION, FIRST>::value || Has<OPTION, OPTIONS...>::value> {};
+    template<typename OPTION, typename... INNER, typename... OPTIONS>
+    struct Has<OPTION, Options<INNER...>, OPTIONS...> : Has<OPTION, INNER..., OPTIONS...> {};
+
+    /*
+     * Registration option: Give the plug-in instance cache lines of its
+     * own. Only for REGISTER_ARENA_PLUGIN (see linktimeplugin-arena.hpp);
+     * the other registrars reject it at compile time.
+     */
+    struct Padded {};
+
+    /**
+     * Keep an arena plug-in from sharing cache lines with its
+     * neighbours, e. g. because it has counters that are written often.
+     * Compilation fails if the plug-in isn't registered with
+     * REGISTER_ARENA_PLUGIN.
+     *
+     * Example:
+     *
+     *      REGISTER_ARENA_PLUGIN(Counter, "counter", linktimeplugin::padded());
+     */
+    constexpr Padded padded() noexcept {
+        return Padded();
+    }
+
+    /*
+     * Registration option: Metadata of the plug-in, which can be
+     * queried through its registrar without constructing the plug-in
+     * (see RegistrarBase::meta()).
+     */
+    struct Meta {
+        const char* name;       // Display name (static storage duration)
+        std::size_t length;     // Length of the name
+        unsigned version;       // Version of the plug-in
+        int priority;           // Meaning defined by the application
+        std::uint64_t flags;    // Capabilities, defined by the application
+
+        // Tells if the plug-in has all of the given capabilities
+        constexpr bool has(std::uint64_t mask) const noexcept {
+            return (flags & mask) == mask;
+        }
+    };
+
+    /**
+     * Describe a plug-in. The arguments are compile-time constants; the
+     * name must be a string literal. Plug-ins registered without
+     * metadata are named by their class name.
+     *
+     * Example:
+     *
+     *      REGISTER_PLUGIN(Cat, "cat", linktimeplugin::meta("Cat", 2, 10, Animal::pet));
+     */
+    template<std::size_t N>
+    constexpr Meta meta(const char (&name)[N], unsigned version = 0, int priority = 0,
+    std::uint64_t flags = 0) noexcept {
+        return Meta{name, N - 1, version, priority, flags};
+    }
+
+    /*
+     * The registration options of a plug-in. REGISTER_PLUGIN makes it
+     * at compile time, so it's in read-only memory and costs nothing at
+     * startup, and the registrar only refers to it.
+     */
+    struct Descriptor {
+        const char* key;                // Key, or nullptr
+        const char* const* after;       // Keys of the plug-ins this one depends on
+        std::size_t dependencies;       // Number of these keys
+        Site site;
+        Meta meta;
+    };
+
+    /*
+     * The registration options of a plug-in as they were passed, kept
+     * by REGISTER_PLUGIN in a constant next to the descriptor, which
+     * refers to the keys of its dependencies.
+     */
+    template<typename... OPTIONS>
+    struct Options {};
+    template<typename OPTION, typename... OPTIONS>
+    struct Options<OPTION, OPTIONS...> {
+        OPTION first;
+        Options<OPTIONS...> rest;
+    };
+
+    constexpr Options<> options() noexcept {
+        return Options<>();
+    }
+    template<typename OPTION, typename... OPTIONS>
+    constexpr Options<OPTION, OPTIONS...> options(OPTION first, OPTIONS... rest) noexcept {
+        return Options<OPTION, OPTIONS...>{first, options(rest...)};
+    }
+
+    // Returns the length of a string at compile time
+    constexpr std::size_t length(const char* s) noexcept {
+        return *s ? 1 + length(s + 1) : 0;
+    }
+
+    // Returns a descriptor with one registration option set
+    constexpr Descriptor describe(const Descriptor& d, const char* key) noexcept {
+        return Descriptor{key, d.after, d.dependencies, d.site, d.meta};
+    }
+    template<std::size_t N>
+    constexpr Descriptor describe(const Descriptor& d, const After<N>& after) noexcept {
+        return Descriptor{d.key, after.keys, N, d.site, d.meta};
+    }
+    constexpr Descriptor describe(const Descriptor& d, const After<0>&) noexcept {
+        return d;
+    }
+    constexpr Descriptor describe(const Descriptor& d, const Site& site) noexcept {
+        return Descriptor{d.key, d.after, d.dependencies, site, d.meta};
+    }
+    constexpr Descriptor describe(const Descriptor& d, const Meta& meta) noexcept {
+        return Descriptor{d.key, d.after, d.dependencies, d.site, meta};
+    }
+    template<std::size_t BYTES>
+    constexpr Descriptor describe(const Descriptor& d, const Budget<BYTES>&) noexcept {
+        return d;
+    }
+    constexpr Descriptor describe(const Descriptor& d, const Padded&) noexcept {
+        return d;
+    }
+
+    // Returns a descriptor with all registration options set
+    constexpr Descriptor describe(const Descriptor& d, const Options<>&) noexcept {
+        return d;
+    }
+    template<typename OPTION, typename... OPTIONS>
+    constexpr Descriptor describe(const Descriptor& d, const Options<OPTION, OPTIONS...>& options) noexcept {
+        return describe(describe(d, options.first), options.rest);
+    }
+
+    // Returns a descriptor that's named by the plug-in's class name
+    // if it has no metadata
+    constexpr Descriptor named(const Descriptor& d) noexcept {
+        return d.meta.name || !d.site.name ? d : Descriptor{d.key, d.after, d.dependencies, d.site,
+            Meta{d.site.name, length(d.site.name), 0, 0, 0}};
+    }
+
+    /**
+     * Collect the registration options of a plug-in into a descriptor.
+     * Without metadata, the plug-in is named by its class name (if
+     * it's known from the Site). The descriptor refers to the keys of
+     * the dependencies in options, so options must outlive it.
+     */
+    template<typename... OPTIONS>
+    constexpr Descriptor describe(const Options<OPTIONS...>& options) noexcept {
+        return named(describe(Descriptor{nullptr, nullptr, 0, Site{nullptr, nullptr, 0}, Meta{nullptr, 0, 0, 0, 0}}, options));
+    }
+
+    // Allocates memory for an object of type T, aligned as T requires
+    // (operator new ignores alignments beyond std::max_align_t before
+    // C++17). Throws std::bad_alloc. Free the memory with deallocate<T>().
+    template<typename T>
+    void* allocate() {
+        if (alignof(T) <= alignof(std::max_align_t)) return ::operator new(sizeof(T));
+
+        // Over-allocate, and remember the allocation in front of the
+        // aligned address (there's room, since both are aligned to
+        // std::max_align_t)
+        const auto raw = ::operator new(sizeof(T) + alignof(T));
+        const auto ret = reinterpret_cast<void*>((reinterpret_cast<std::uintptr_t>(raw) + alignof(T)) / alignof(T) * alignof(T));
+        static_cast<void**>(ret)[-1] = raw;
+        return ret;
+    }
+
+    template<typename T>
+    void deallocate(void* p) noexcept {
+        if (!p) return;
+        ::operator delete(alignof(T) <= alignof(std::max_align_t) ? p : static_cast<void**>(p)[-1]);
+    }
+
+    template<typename BASE>
+    class RegistrarBase;
+
+    // The bytes that a plug-in adds to its registrar: The plug-in
+    // object, placed after the registrar base class, and the padding
+    // before and after it.
+    template<typename PLUGIN>
+    struct Footprint {
+        using Base = RegistrarBase<typename PLUGIN::Base>;
+        static constexpr std::size_t align = alignof(PLUGIN) > alignof(Base) ? alignof(PLUGIN) : alignof(Base);
+        static constexpr std::size_t offset = (sizeof(Base) + alignof(PLUGIN) - 1) / alignof(PLUGIN) * alignof(PLUGIN);
+        static constexpr std::size_t value = (offset + sizeof(PLUGIN) + align - 1) / align * align - sizeof(Base);
+    };
+
     /*
      * Base class for plug-in registrars. A registrar is an intermediate
      * class that manages the registration of one plug-in class (which
@@ -34,52 +458,1031 @@ namespace linktimeplugin {
      */
     template<typename BASE>
     class RegistrarBase {
+        struct Slot;
+
     public:
-        // Ctor. Adds this object to the list of registrars.
-        RegistrarBase() noexcept {
+        /*
+         * Read-only table of a frozen registry (see freeze()). Its
+         * arrays are laid out one after another in a single memory
+         * block, and entry i of each array refers to the same plug-in.
+         */
+        struct Table {
+            std::size_t size;                       // Number of plug-ins
+            BASE** plugins;                         // Plug-in instances
+            RegistrarBase<BASE>** registrars;       // Their registrars
+            const char** keys;                      // Their keys (or nullptr)
+            const Slot* index;                      // Key index
+            std::size_t mask;                       // Key index size - 1
+            std::unique_ptr<unsigned char[]> memory;
+        };
+
+        // Ctor for REGISTER_PLUGIN, which collects the options in a
+        // descriptor at compile time (see describe()). The registrar
+        // refers to the descriptor, which must outlive it. The derived
+        // registrar adds itself to the list of registrars once its
+        // plug-in instance is constructed.
+        template<typename... OPTIONS>
+        RegistrarBase(const Descriptor& descriptor, const Options<OPTIONS...>&) noexcept
+        : descriptor_(&descriptor) {
+            open();
+        }
+
+        // Ctor for registrars that are constructed at run time. The
+        // options are the optional REGISTER_PLUGIN arguments after the
+        // plug-in class name, in any order: The key (which must point
+        // to a string that outlives the registrar), the dependencies
+        // (After), and the metadata (Meta). REGISTER_PLUGIN adds the
+        // class name and source location (Site). They're copied into a
+        // descriptor of the registrar's own; if there's not enough
+        // memory for it, the plug-in fails.
+        template<typename... OPTIONS>
+        explicit RegistrarBase(OPTIONS&&... options) noexcept {
             try {
-                if (!registrars_) {
-                    registrars_.reset(new std::vector<RegistrarBase<BASE>*>);
-                }
-                registrars_->push_back(this);
-            } catch(...) {}
+                std::unique_ptr<Owned> d(new Owned(describe(linktimeplugin::options(options...))));
+                d->keys.assign(d->after, d->after + d->dependencies);
+                d->after = d->keys.data();
+                descriptor_ = d.release();
+                owned_ = true;
+            } catch(...) {
+                descriptor_ = &none();
+                failed_.store(true);
+            }
+            open();
+        }
+
+        // Dtor. Unregisters the plug-in, unless the derived registrar
+        // did already. Registrars aren't polymorphic; they're never
+        // destroyed through a pointer to the base class.
+        ~RegistrarBase() {
+            remove();
+            if (owned_) delete static_cast<const Owned*>(descriptor_);
         }
 
         // Rule of 5
-        virtual ~RegistrarBase() = default;
         RegistrarBase(const RegistrarBase&) = delete;
         RegistrarBase(RegistrarBase&&) = delete;
         void operator=(const RegistrarBase&) = delete;
         void operator=(RegistrarBase&&) = delete;
 
-        // Implemented by the derived registrar class.
-        virtual BASE& operator()() = 0;
+        // Returns the plug-in instance, constructing it if necessary.
+        // Throws if the plug-in's ctor throws. The instance pointer is
+        // recorded once, so this is a plain load; only the first use
+        // of a lazy plug-in calls through the registrar's ctor thunk.
+        BASE& operator()() {
+            if (const auto p = plugin_.load(std::memory_order_acquire)) {
+                return *p;
+            }
+            const auto p = thunks_->make(*this);
+            plugin_.store(p, std::memory_order_release);
+            return *p;
+        }
+
+        // Returns the plug-in instance, constructing it if necessary.
+        // Returns nullptr if the construction fails.
+        BASE* get() noexcept {
+            if (const auto p = plugin_.load(std::memory_order_acquire)) {
+                return p;
+            }
+            try {
+                return &(*this)();
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        // Returns the calling thread's instance of the plug-in: Its own
+        // for per-thread plug-ins (see linktimeplugin-local.hpp), the
+        // shared one for all others. Constructs it if necessary;
+        // returns nullptr if the construction fails.
+        BASE* local() noexcept {
+            if (!thunks_->local) return get();
+            try {
+                return thunks_->local(*this);
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        // Returns the key given at registration, or nullptr.
+        const char* key() const noexcept { return descriptor_->key; }
+
+        // Returns a number that identifies the registrar among all
+        // registrars of its plug-in base class that were ever
+        // constructed. Unlike its position in registrars(), it doesn't
+        // change when other plug-ins are unregistered.
+        std::size_t id() const noexcept { return id_; }
 
-        // Returns all registrars.
-        static std::vector<BASE*> plugins() {
-            std::vector<BASE*> ret;
+        // Returns the class name and source location given at
+        // registration (all nullptr if not registered with the
+        // REGISTER_... macros).
+        const Site& site() const noexcept { return descriptor_->site; }
 
-            if (registrars_) {
-                for(auto r : *registrars_) {
-                    ret.push_back(&(*r)());
+        // Returns the metadata given at registration. Without any, the
+        // name is the class name (if known) and everything else is 0.
+        // Doesn't construct the plug-in.
+        const Meta& meta() const noexcept { return descriptor_->meta; }
+
+#ifdef LINKTIMEPLUGIN_HEAP
+        // Returns the plug-in's heap account, or nullptr.
+        heap::Account* account() const noexcept { return account_; }
+#endif
+
+        // Returns the keys of the plug-ins this one depends on.
+        View<const char> after() const noexcept {
+            return View<const char>(descriptor_->after, descriptor_->dependencies);
+        }
+
+        // Returns true if the plug-in couldn't be initialized.
+        bool failed() const noexcept { return failed_.load(); }
+
+        // Marks the plug-in as failed, which leaves it out of plugins().
+        // If the registry is frozen, the table is built again without
+        // the plug-in (or dropped if there's not enough memory, like
+        // when a plug-in is unregistered).
+        void fail() noexcept {
+            failed_.store(true);
+            std::lock_guard<std::mutex> lock(mutex());
+            if (!registered_) return;
+            rebuild();
+            if (const auto t = frozen_.load()) {
+                Table* n = nullptr;
+                if (const auto s = current_.load()) {
+                    try {
+                        n = table(s->registrars->items.get(), s->size).release();
+                    } catch(...) {}
+                }
+                frozen_.store(n);
+                epoch::retire(t);
+            }
+        }
+
+        // Constructs the plug-in (if necessary) and runs its init()
+        // hook (if it has one and it didn't run before). Returns false
+        // if the plug-in couldn't be constructed or its init() threw.
+        // A plug-in that fails here is left out of plugins().
+        bool initialize() noexcept {
+            const auto p = get();
+            if (!p) return false;
+
+            if (thunks_->init && !initialized_.exchange(true)) {
+#ifdef LINKTIMEPLUGIN_TIMING
+                const auto start = profile::now();
+#endif
+                try {
+#ifdef LINKTIMEPLUGIN_HEAP
+                    const heap::Tag tag(account_);
+#endif
+                    thunks_->init(*p);
+                } catch(...) {
+                    fail();
+                }
+#ifdef LINKTIMEPLUGIN_TIMING
+                initialized(start, profile::now());
+#endif
+            }
+            return !failed_.load();
+        }
+
+        // Returns all registrars, in order of registration. This is a
+        // pointer and a size; it never locks or allocates. The view is
+        // valid until the registry changes; if other threads may
+        // unregister plug-ins, hold a Pin while using it.
+        static View<RegistrarBase<BASE>> registrars() noexcept {
+            const auto s = current_.load();
+            return s
+                ? View<RegistrarBase<BASE>>(s->registrars->items.get(), s->size)
+                : View<RegistrarBase<BASE>>();
+        }
+
+        // Returns all plug-ins. Usually, this is a pointer and a size.
+        // If the registry has lazy plug-ins, the first call after a
+        // change constructs them and lists them once. Never locks (but
+        // the construction of a lazy plug-in waits for another thread
+        // that constructs it at the same time). The view is valid until
+        // the registry changes; if other threads may unregister
+        // plug-ins, hold a Pin while using it.
+        static Plugins<BASE> plugins() noexcept {
+            const Pin pin;
+            Plugins<BASE> ret;
+            if (const auto t = frozen_.load()) {
+                ret = Plugins<BASE>(t->plugins, t->size);
+            } else if (const auto s = current_.load()) {
+                if (s->plugins) {
+                    ret = Plugins<BASE>(s->plugins->items.get(), s->count);
+                } else if (const auto e = enumerate(*s)) {
+                    ret = Plugins<BASE>(e->plugins.data(), e->plugins.size());
                 }
             }
+            LINKTIMEPLUGIN_PROBE2(plugins, typeid(BASE).name(), ret.size());
+            return ret;
+        }
 
+        // Returns the plug-in registered with the given key, or nullptr.
+        // This is one hash and, usually, one string comparison. If other
+        // threads may unregister plug-ins, hold a Pin while using the
+        // plug-in.
+        static BASE* find(const char* key, std::size_t length) noexcept {
+            const Pin pin;
+            const auto r = registrar(key, length);
+            const auto ret = r && !r->failed() ? r->get() : nullptr;
+            LINKTIMEPLUGIN_PROBE4(find, typeid(BASE).name(), key, length, ret);
             return ret;
         }
 
+        // Returns the registrar of the plug-in registered with the
+        // given key, or nullptr. Like with find(), hold a Pin while
+        // using it if other threads may unregister plug-ins.
+        static RegistrarBase<BASE>* registrar(const char* key, std::size_t length) noexcept {
+            const Pin pin;
+            const auto h = hash(key, length);
+
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+            // Keys that were known at build time are in the perfect
+            // hash table, all others are in the index.
+            const auto slot = perfect_hash.find(key, length, h);
+            if (slot != perfect_hash.size) {
+                const auto k = known_.load();
+                return k ? k[slot].load() : nullptr;
+            }
+#endif
+
+            if (const auto t = frozen_.load()) {
+                return probe(t->index, t->mask, key, length, h);
+            }
+            const auto s = current_.load();
+            return s ? probe(s->index->slots.get(), s->index->mask, key, length, h) : nullptr;
+        }
+
+        // Compacts the registry into a read-only table. Constructs all
+        // lazy plug-ins; plug-ins that fail are left out. Afterwards,
+        // plugins() and find() use the table without any locking or
+        // checking, and further registrations are rejected (see
+        // rejected()). Unregistering a plug-in drops the table (the
+        // registry then uses snapshots again). Returns the table, or
+        // nullptr if there's not enough memory (the registry stays as
+        // it is then).
+        static const Table* freeze() noexcept {
+            for (;;) {
+                // Construct the plug-ins, without holding the lock
+                const Pin pin;
+                const auto s = current_.load();
+                if (s && !s->plugins && !enumerate(*s)) return nullptr;
+
+                std::lock_guard<std::mutex> lock(mutex());
+                if (const auto t = frozen_.load()) {
+                    return t;
+                }
+                if (current_.load() != s) continue;
+
+                try {
+                    frozen_.store(s
+                        ? table(s->registrars->items.get(), s->size).release()
+                        : table(nullptr, 0).release());
+                    sealed_.store(true);
+                } catch(...) {}
+                return frozen_.load();
+            }
+        }
+
+        // Returns the number of registrations that were rejected
+        // because they happened after freeze().
+        static std::size_t rejected() noexcept {
+            return rejected_.load();
+        }
+
+        // Returns a number that changes whenever the registry changes
+        // (a plug-in is registered, unregistered, or fails).
+        static std::uint64_t version() noexcept {
+            return version_.load();
+        }
+
+    protected:
+        // Function that constructs the plug-in instance of a registrar
+        // (once) and returns it
+        using Make = BASE* (*)(RegistrarBase<BASE>&);
+
+        // Adds this registrar to the registry. PLUGIN is the plug-in
+        // class, plugin is its instance, or nullptr if it's
+        // constructed on first use by MAKE. LOCAL returns the calling
+        // thread's instance of a per-thread plug-in.
+        template<typename PLUGIN, Make MAKE = nullptr, Make LOCAL = nullptr>
+        void add(BASE* plugin) noexcept {
+#ifdef LINKTIMEPLUGIN_TIMING
+            const auto end = profile::now();
+#endif
+#ifdef LINKTIMEPLUGIN_HEAP
+            heap::current() = tagged_;
+            if (!site().name) heap::rename(account_, profile::name(typeid(PLUGIN)));
+#endif
+            static constexpr Thunks thunks{MAKE, LOCAL, hook<PLUGIN>(0)};
+            thunks_ = &thunks;
+            plugin_.store(plugin, std::memory_order_release);
+
+#ifdef LINKTIMEPLUGIN_TRACE
+            // Only registrars that were constructed at run time have
+            // no class name, and their descriptor is their own
+            if (!site().name && owned_) {
+                const_cast<Owned*>(static_cast<const Owned*>(descriptor_))->site.name = trace::name<PLUGIN>();
+            }
+#endif
+#ifdef LINKTIMEPLUGIN_PROFILE
+            profile_ = profile::add(site().name, typeid(PLUGIN), site().file, site().line, !plugin, -1, -1);
+#endif
+#ifdef LINKTIMEPLUGIN_TIMING
+            if (plugin) constructed(start_, end);
+#endif
+#ifdef LINKTIMEPLUGIN_TRACE
+            trace::instant("registration", site().name, trace::name<BASE>());
+#endif
+            LINKTIMEPLUGIN_PROBE3(registered, typeid(BASE).name(), site().name, key());
+
+            try {
+                std::lock_guard<std::mutex> lock(mutex());
+
+                // The registry is read-only after freeze()
+                if (sealed_.load()) {
+                    failed_.store(true);
+                    ++rejected_;
+                    return;
+                }
+
+                if (!registrars_) {
+                    registrars_ = new std::vector<RegistrarBase<BASE>*>;
+                }
+                registrars_->push_back(this);
+                try {
+                    publish(added(current_.load()).release());
+                } catch(...) {
+                    registrars_->pop_back();
+                    throw;
+                }
+                registered_ = true;
+            } catch(...) {}
+        }
+
+        // Removes this registrar from the registry, and waits until no
+        // other thread can find it anymore (unless the calling thread
+        // holds a Pin). Derived registrars call this before they
+        // destroy their plug-in.
+        void remove() noexcept {
+            {
+                std::lock_guard<std::mutex> lock(mutex());
+                if (!registered_) return;
+                registered_ = false;
+
+                // Registrars are usually destroyed in the reverse order
+                // of registration, so search from the back
+                const auto it = std::find(registrars_->rbegin(), registrars_->rend(), this);
+                if (it != registrars_->rend()) {
+                    registrars_->erase(std::next(it).base());
+                }
+                try {
+                    publish(removed(current_.load()).release());
+                } catch(...) {
+                    // Better an empty registry than one that refers to
+                    // this registrar. The next change rebuilds it.
+                    publish(nullptr);
+                }
+                if (const auto t = frozen_.exchange(nullptr)) {
+                    epoch::retire(t);
+                }
+            }
+            epoch::synchronize();
+        }
+
+        // Constructs the plug-in instance in the given storage, measuring
+        // the construction and booking its allocations. Throws if the
+        // plug-in's ctor throws.
+        template<typename PLUGIN>
+        PLUGIN* construct(void* storage) {
+#ifdef LINKTIMEPLUGIN_HEAP
+            const heap::Tag tag(account_);
+#endif
+#ifdef LINKTIMEPLUGIN_TIMING
+            const auto start = profile::now();
+            const auto ret = new(storage) PLUGIN;
+            constructed(start, profile::now());
+            return ret;
+#else
+            return new(storage) PLUGIN;
+#endif
+        }
+
+        // Runs the init() hook (if the plug-in class has one) on another
+        // instance of the plug-in class than the registrar's own, e. g.
+        // a per-thread one, booking its allocations. Throws if init()
+        // throws.
+        void init(BASE& instance) {
+            if (!thunks_->init) return;
+#ifdef LINKTIMEPLUGIN_HEAP
+            const heap::Tag tag(account_);
+#endif
+            thunks_->init(instance);
+        }
+
+#ifdef LINKTIMEPLUGIN_TIMING
+        // Records the construction of the plug-in and the run of
+        // its init() hook
+        void constructed(std::int64_t start, std::int64_t end) noexcept {
+#ifdef LINKTIMEPLUGIN_PROFILE
+            profile::set(profile_, &profile::Record::construction, start, end);
+#endif
+#ifdef LINKTIMEPLUGIN_TRACE
+            trace::complete("construction", site().name, trace::name<BASE>(), start, end);
+#endif
+        }
+        void initialized(std::int64_t start, std::int64_t end) noexcept {
+#ifdef LINKTIMEPLUGIN_PROFILE
+            profile::set(profile_, &profile::Record::init, start, end);
+#endif
+#ifdef LINKTIMEPLUGIN_TRACE
+            trace::complete("init", site().name, trace::name<BASE>(), start, end);
+#endif
+        }
+#endif
+
     private:
+        // The descriptor of a registrar that was constructed at run
+        // time, with a copy of the keys of the dependencies
+        struct Owned : Descriptor {
+            explicit Owned(const Descriptor& d) : Descriptor(d) {}
+            std::vector<const char*> keys;
+        };
+
+        // The descriptor of a registrar without any options
+        static const Descriptor& none() noexcept {
+            static constexpr Descriptor ret{nullptr, nullptr, 0, Site{nullptr, nullptr, 0}, Meta{nullptr, 0, 0, 0, 0}};
+            return ret;
+        }
+
+        // Starts measuring the construction of the plug-in and booking
+        // its allocations, which the derived registrar does between
+        // here and add()
+        void open() noexcept {
+#ifdef LINKTIMEPLUGIN_TIMING
+            start_ = profile::now();
+#endif
+#ifdef LINKTIMEPLUGIN_HEAP
+            account_ = heap::open(descriptor_->site.name);
+            tagged_ = heap::current();
+            heap::current() = account_;
+#endif
+        }
+
+        // Function that calls the plug-in's init() hook
+        using Hook = void(*)(BASE&);
+
+        // Calls the init() hook of a plug-in class
+        template<typename PLUGIN>
+        static void run(BASE& plugin) {
+            static_cast<PLUGIN&>(plugin).init();
+        }
+
+        // Returns the init() hook of a plug-in class that has a public
+        // init() member function, and nullptr for all others.
+        template<typename PLUGIN>
+        static constexpr auto hook(int) noexcept -> decltype(std::declval<PLUGIN&>().init(), Hook()) {
+            return &run<PLUGIN>;
+        }
+        template<typename PLUGIN>
+        static constexpr Hook hook(long) noexcept {
+            return nullptr;
+        }
+
+        // The functions that depend on the plug-in class and the
+        // derived registrar, one constant per combination (see add())
+        struct Thunks {
+            Make make;      // Constructs the plug-in instance, if it's lazy
+            Make local;     // Returns the calling thread's instance, if it has one
+            Hook init;      // Runs the plug-in's init() hook, if it has one
+        };
+
+        // Entry of the key index. The writer fills in an unused entry
+        // (registrar nullptr) and then sets its registrar, which tells
+        // readers that the other members are valid. An entry whose
+        // plug-in was unregistered gets the tombstone() registrar.
+        struct Slot {
+            std::uint64_t hash;
+            const char* key;
+            std::size_t length;
+            std::atomic<RegistrarBase<BASE>*> registrar{nullptr};
+        };
+
+        // Registrar of unregistered index entries
+        static RegistrarBase<BASE>* tombstone() noexcept {
+            return reinterpret_cast<RegistrarBase<BASE>*>(std::uintptr_t(1));
+        }
+
+        /*
+         * Array that consecutive snapshots share. The writer appends to
+         * it in place as long as there's room and no snapshot has seen
+         * an entry past the end of the new snapshot; readers only read
+         * the entries of their own snapshot.
+         */
+        template<typename T>
+        struct Array {
+            explicit Array(std::size_t capacity)
+            : items(new T[capacity]), capacity(capacity) {}
+
+            std::unique_ptr<T[]> items;
+            std::size_t capacity;
+            std::size_t used = 0;       // Entries written (changed under mutex())
+        };
+
+        /*
+         * Key index that consecutive snapshots share: An open-addressing
+         * hash table with linear probing. Its size is a power of two,
+         * and it's at most half full (counting the tombstones). If a
+         * key is registered more than once, the first registration
+         * wins. The writer adds and removes keys in place.
+         */
+        struct Index {
+            explicit Index(std::size_t slots)
+            : slots(new Slot[slots]), mask(slots - 1) {}
+
+            std::unique_ptr<Slot[]> slots;
+            std::size_t mask;
+            std::size_t used = 0;       // Entries in use, including tombstones
+        };
+
+        // The plug-ins of a snapshot, listed by a reader (see enumerate())
+        struct Enumeration {
+            std::vector<BASE*> plugins;
+        };
+
+        /*
+         * Immutable snapshot of the registry. The writers publish a new
+         * one whenever the registry changes, and retire the old one;
+         * readers use the current one without locking (see
+         * linktimeplugin-epoch.hpp).
+         */
+        struct Snapshot {
+            std::shared_ptr<Array<RegistrarBase<BASE>*>> registrars;    // In order of registration
+            std::size_t size = 0;
+            std::shared_ptr<Index> index;
+
+            // The plug-ins, if all of them were constructed when the
+            // snapshot was built; otherwise, the first reader that needs
+            // them lists them
+            std::shared_ptr<Array<BASE*>> plugins;
+            std::size_t count = 0;
+            std::atomic<Enumeration*> enumeration{nullptr};
+
+            ~Snapshot() {
+                delete enumeration.load();
+            }
+        };
+
+        // Returns the plug-ins of a snapshot that has no complete list,
+        // constructing the lazy ones, or nullptr if there's not enough
+        // memory. The first reader lists them; the others use its list.
+        // Plug-ins whose construction fails are left out.
+        static const Enumeration* enumerate(Snapshot& s) noexcept {
+            if (const auto e = s.enumeration.load()) {
+                return e;
+            }
+            try {
+                std::unique_ptr<Enumeration> e(new Enumeration);
+                e->plugins.reserve(s.size);
+                for (std::size_t i = 0; i < s.size; ++i) {
+                    const auto r = s.registrars->items[i];
+                    if (r->failed_.load()) continue;
+                    if (const auto p = r->get()) {
+                        e->plugins.push_back(p);
+                    }
+                }
+                Enumeration* expected = nullptr;
+                if (s.enumeration.compare_exchange_strong(expected, e.get())) {
+                    return e.release();
+                }
+                return expected;
+            } catch(...) {
+                return nullptr;
+            }
+        }
+
+        // Publishes a new snapshot (or none, which means an empty
+        // registry) and retires the old one. Call with mutex() held.
+        static void publish(Snapshot* s) noexcept {
+            ++version_;
+            if (const auto old = current_.exchange(s)) {
+                epoch::retire(old);
+            }
+        }
+
+        // Publishes a snapshot of registrars_ that's built from scratch.
+        // Call with mutex() held.
+        static void rebuild() noexcept {
+            try {
+                publish(build().release());
+            } catch(...) {
+                publish(nullptr);
+            }
+        }
+
+        // Returns the capacity for n entries, leaving room to grow
+        static std::size_t room(std::size_t n) noexcept {
+            return n < 8 ? 16 : n * 2;
+        }
+
+        // Tells if a registrar's key is in the perfect hash table, and
+        // returns its slot there
+        static bool known(const RegistrarBase<BASE>& r, std::size_t& slot) noexcept {
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+            const auto length = std::strlen(r.key());
+            slot = perfect_hash.find(r.key(), length, hash(r.key(), length));
+            return slot != perfect_hash.size;
+#else
+            (void)r;
+            (void)slot;
+            return false;
+#endif
+        }
+
+        // Builds a snapshot of registrars_ from scratch, and refills
+        // the perfect hash table. Throws if there's not enough memory
+        // (nothing is changed then). Call with mutex() held.
+        static std::unique_ptr<Snapshot> build() {
+            const auto n = registrars_ ? registrars_->size() : 0;
+            std::unique_ptr<Snapshot> s(new Snapshot);
+            s->registrars = std::make_shared<Array<RegistrarBase<BASE>*>>(room(n));
+            s->size = n;
+
+            // The plug-ins, if all of them are constructed
+            std::size_t count = 0;
+            auto complete = true;
+            std::size_t keys = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto r = (*registrars_)[i];
+                s->registrars->items[i] = r;
+                if (r->key()) ++keys;
+                if (r->failed_.load()) continue;
+                if (r->plugin_.load()) {
+                    ++count;
+                } else {
+                    complete = false;
+                }
+            }
+            s->registrars->used = n;
+            if (complete) {
+                s->plugins = std::make_shared<Array<BASE*>>(room(count));
+                for (std::size_t i = 0; i < n; ++i) {
+                    const auto r = (*registrars_)[i];
+                    if (!r->failed_.load()) s->plugins->items[s->count++] = r->plugin_.load();
+                }
+                s->plugins->used = s->count;
+            }
+
+            // The key index, with room for as many keys again
+            std::size_t slots = 1;
+            while (slots < keys * 4) slots *= 2;
+            s->index = std::make_shared<Index>(slots);
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+            // The perfect hash table is shared by all snapshots, so its
+            // entries are overwritten rather than cleared and refilled
+            std::vector<RegistrarBase<BASE>*> winners(perfect_hash.size);
+            auto k = known_.load();
+            if (!k && perfect_hash.size > 0) {
+                k = new std::atomic<RegistrarBase<BASE>*>[perfect_hash.size]();
+                known_.store(k);
+            }
+#endif
+
+            // Nothing can fail from here on
+            duplicates_ = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto r = (*registrars_)[i];
+                if (!r->key()) continue;
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+                std::size_t slot;
+                if (known(*r, slot)) {
+                    if (winners[slot]) {
+                        ++duplicates_;
+                    } else {
+                        winners[slot] = r;
+                    }
+                    continue;
+                }
+#endif
+                enter(*s->index, *r);
+            }
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+            for (std::size_t i = 0; i < perfect_hash.size; ++i) {
+                k[i].store(winners[i]);
+            }
+#endif
+            return s;
+        }
+
+        // Enters the key of a registrar into the index, or into the
+        // perfect hash table, unless it's there already (which is
+        // counted in duplicates_). The index must have room for it.
+        static void enter(Index& index, RegistrarBase<BASE>& r) noexcept {
+            std::size_t slot;
+            if (known(r, slot)) {
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+                auto& k = known_.load()[slot];
+                if (k.load()) {
+                    ++duplicates_;
+                } else {
+                    k.store(&r);
+                }
+#endif
+                return;
+            }
+            const auto length = std::strlen(r.key());
+            const auto h = hash(r.key(), length);
+            if (probe(index.slots.get(), index.mask, r.key(), length, h)) {
+                ++duplicates_;
+                return;
+            }
+            insert(index.slots.get(), index.mask, h, r.key(), length, &r);
+            ++index.used;
+        }
+
+        // Returns the snapshot after the last registrar in registrars_
+        // was added to the current snapshot s. Appends to the arrays and
+        // the index in place if it can, else builds from scratch. Throws
+        // if there's not enough memory. Call with mutex() held.
+        static std::unique_ptr<Snapshot> added(const Snapshot* s) {
+            const auto r = registrars_->back();
+            if (!s || s->registrars->used != s->size || s->size == s->registrars->capacity) {
+                return build();
+            }
+
+            // Room for the key?
+            std::size_t slot;
+            if (r->key() && !known(*r, slot) && (s->index->used + 1) * 2 > s->index->mask + 1) {
+                return build();
+            }
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+            if (r->key() && known(*r, slot) && !known_.load()) {
+                return build();
+            }
+#endif
+
+            // The plug-ins: Append if the list is complete and the new
+            // plug-in is constructed. A lazy plug-in makes the list
+            // incomplete.
+            const auto p = r->plugin_.load();
+            std::shared_ptr<Array<BASE*>> plugins;
+            if (p && !r->failed_.load()) {
+                if (s->plugins) {
+                    if (s->plugins->used != s->count || s->count == s->plugins->capacity) {
+                        return build();
+                    }
+                    plugins = s->plugins;
+                } else if (s->enumeration.load()) {
+                    // Readers constructed the lazy plug-ins meanwhile
+                    return build();
+                }
+            }
+
+            std::unique_ptr<Snapshot> n(new Snapshot);
+            n->registrars = s->registrars;
+            n->index = s->index;
+            n->plugins = plugins;
+
+            // Nothing can fail from here on
+            n->registrars->items[n->registrars->used++] = r;
+            n->size = s->size + 1;
+            if (plugins) {
+                plugins->items[plugins->used++] = p;
+                n->count = s->count + 1;
+            }
+            if (r->key()) enter(*n->index, *r);
+            return n;
+        }
+
+        // Returns the snapshot after this registrar was removed from
+        // the current snapshot s. If it's the last one, the arrays are
+        // shared and its key is removed from the index in place; else
+        // the snapshot is built from scratch. Throws if there's not
+        // enough memory. Call with mutex() held.
+        std::unique_ptr<Snapshot> removed(const Snapshot* s) {
+            if (!s || s->size == 0 || s->registrars->items[s->size - 1] != this || duplicates_ > 0) {
+                return build();
+            }
+
+            // The plug-ins: This one is the last in the list, or not
+            // in it at all
+            const auto p = plugin_.load();
+            std::size_t count = s->count;
+            if (s->plugins && s->count > 0 && s->plugins->items[s->count - 1] == p) {
+                --count;
+            } else if (s->plugins && p && !failed_.load()) {
+                return build();
+            }
+
+            std::unique_ptr<Snapshot> n(new Snapshot);
+            n->registrars = s->registrars;
+            n->size = s->size - 1;
+            n->index = s->index;
+            n->plugins = s->plugins;
+            n->count = count;
+
+            // Nothing can fail from here on
+            if (key()) {
+                std::size_t slot;
+                if (known(*this, slot)) {
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+                    auto& k = known_.load()[slot];
+                    if (k.load() == this) k.store(nullptr);
+#endif
+                } else {
+                    const auto length = std::strlen(key());
+                    const auto h = hash(key(), length);
+                    const auto& index = *n->index;
+                    for (auto i = static_cast<std::size_t>(h) & index.mask;; i = (i + 1) & index.mask) {
+                        auto& entry = index.slots[i];
+                        const auto r = entry.registrar.load();
+                        if (!r) break;
+                        if (r == this) {
+                            entry.registrar.store(tombstone());
+                            break;
+                        }
+                    }
+                }
+            }
+            return n;
+        }
+
+        // Builds the table of a frozen registry from the plug-ins that
+        // are available
+        static std::unique_ptr<Table> table(RegistrarBase<BASE>* const* registrars, std::size_t size) {
+            std::vector<RegistrarBase<BASE>*> entries;
+            std::size_t keys = 0;
+            for (std::size_t i = 0; i < size; ++i) {
+                const auto r = registrars[i];
+                if (!r->failed() && r->plugin_.load()) {
+                    entries.push_back(r);
+                    if (r->key()) ++keys;
+                }
+            }
+
+            // Allocate the table: The key index (a power of two, at
+            // most half full), followed by the per-plug-in arrays.
+            const auto n = entries.size();
+            std::size_t slots = 1;
+            while (slots < keys * 2) slots *= 2;
+            std::unique_ptr<Table> t(new Table);
+            t->memory.reset(new unsigned char[
+                slots * sizeof(Slot) +
+                n * (sizeof(BASE*) + sizeof(RegistrarBase<BASE>*) + sizeof(const char*))]);
+
+            const auto slot = static_cast<Slot*>(static_cast<void*>(t->memory.get()));
+            for (std::size_t i = 0; i < slots; ++i) {
+                ::new(&slot[i]) Slot;
+            }
+            t->plugins = static_cast<BASE**>(static_cast<void*>(slot + slots));
+            t->registrars = static_cast<RegistrarBase<BASE>**>(static_cast<void*>(t->plugins + n));
+            t->keys = static_cast<const char**>(static_cast<void*>(t->registrars + n));
+            t->size = n;
+            t->index = slot;
+            t->mask = slots - 1;
+
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto r = entries[i];
+                ::new(&t->plugins[i]) BASE*(r->plugin_.load());
+                ::new(&t->registrars[i]) RegistrarBase<BASE>*(r);
+                ::new(&t->keys[i]) const char*(r->key());
+
+                if (r->key()) {
+                    const auto length = std::strlen(r->key());
+                    const auto h = hash(r->key(), length);
+                    if (!probe(slot, t->mask, r->key(), length, h)) {
+                        insert(slot, t->mask, h, r->key(), length, r);
+                    }
+                }
+            }
+            return t;
+        }
+
+        // Looks up a key in an index
+        static RegistrarBase<BASE>* probe(const Slot* index, std::size_t mask,
+        const char* key, std::size_t length, std::uint64_t h) noexcept {
+            for (auto i = static_cast<std::size_t>(h) & mask;; i = (i + 1) & mask) {
+                const auto& slot = index[i];
+                const auto r = slot.registrar.load(std::memory_order_acquire);
+                if (!r) return nullptr;
+                if (r != tombstone() && slot.hash == h && slot.length == length
+                && std::memcmp(slot.key, key, length) == 0) {
+                    return r;
+                }
+            }
+        }
+
+        // Inserts a key into an index that has room for it
+        static void insert(Slot* index, std::size_t mask,
+        std::uint64_t h, const char* key, std::size_t length, RegistrarBase<BASE>* r) noexcept {
+            auto i = static_cast<std::size_t>(h) & mask;
+            while (index[i].registrar.load(std::memory_order_relaxed)) i = (i + 1) & mask;
+            auto& slot = index[i];
+            slot.hash = h;
+            slot.key = key;
+            slot.length = length;
+            slot.registrar.store(r, std::memory_order_release);
+        }
+
+        // Returns the next registrar's id
+        static std::uint32_t next() noexcept {
+            static std::atomic<std::uint32_t> ret{0};
+            return ret.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // The registration options
+        const Descriptor* descriptor_;
+
+        // The plug-in instance, once it's constructed, and the functions
+        // that construct it and run its init() hook
+        std::atomic<BASE*> plugin_{nullptr};
+        const Thunks* thunks_ = nullptr;
+
+        // The registrar's id, see id()
+        const std::uint32_t id_ = next();
+
+        // The state of the plug-in's init() hook
+        std::atomic<bool> initialized_{false};
+        std::atomic<bool> failed_{false};
+
+        // Whether the registrar is in registrars_ (changed under
+        // mutex()), and whether descriptor_ is its own
+        bool registered_ = false;
+        bool owned_ = false;
+
+#ifdef LINKTIMEPLUGIN_TIMING
+        // When the construction of the plug-in started
+        std::int64_t start_ = -1;
+#endif
+#ifdef LINKTIMEPLUGIN_PROFILE
+        // The plug-in's profile record
+        profile::Record* profile_ = nullptr;
+#endif
+#ifdef LINKTIMEPLUGIN_HEAP
+        // The plug-in's heap account, and the account that was booked
+        // on before the registrar was constructed
+        heap::Account* account_ = nullptr;
+        heap::Account* tagged_ = nullptr;
+#endif
+
         // Pointers to the registrar objects (one per registered
-        // plug-in class).
-        static std::unique_ptr<std::vector<RegistrarBase<BASE>*>> registrars_;
+        // plug-in class), in order of registration. Changed under
+        // mutex() only; never freed, so that registrars can unregister
+        // during static destruction.
+        static std::vector<RegistrarBase<BASE>*>* registrars_;
+
+        // The current snapshot, or nullptr if the registry is empty
+        static std::atomic<Snapshot*> current_;
+
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+        // The registrars by perfect hash slot, changed in place under
+        // mutex(). Never freed.
+        static std::atomic<std::atomic<RegistrarBase<BASE>*>*> known_;
+#endif
+
+        // Number of keys that were registered more than once (changed
+        // under mutex())
+        static std::size_t duplicates_;
+
+        // The mutex that serializes the writers. Never freed, like
+        // registrars_.
+        static std::mutex& mutex() noexcept {
+            static const auto ret = new std::mutex;
+            return *ret;
+        }
+
+        // The table made by freeze(), whether registrations are
+        // rejected, and the number of registrations rejected
+        static std::atomic<Table*> frozen_;
+        static std::atomic<bool> sealed_;
+        static std::atomic<std::size_t> rejected_;
+
+        // Incremented whenever the registry changes (see version())
+        static std::atomic<std::uint64_t> version_;
     };
 
     /*
-     * Static member of the registrar base class.
+     * Static members of the registrar base class.
      * BASE is the plug-in base class.
      */
     template<typename BASE>
-    std::unique_ptr<std::vector<RegistrarBase<BASE>*>> RegistrarBase<BASE>::registrars_;
+    std::vector<RegistrarBase<BASE>*>* RegistrarBase<BASE>::registrars_ = nullptr;
+    template<typename BASE>
+    std::atomic<typename RegistrarBase<BASE>::Snapshot*> RegistrarBase<BASE>::current_{nullptr};
+#ifdef LINKTIMEPLUGIN_PERFECT_HASH
+    template<typename BASE>
+    std::atomic<std::atomic<RegistrarBase<BASE>*>*> RegistrarBase<BASE>::known_{nullptr};
+#endif
+    template<typename BASE>
+    std::size_t RegistrarBase<BASE>::duplicates_ = 0;
+    template<typename BASE>
+    std::atomic<typename RegistrarBase<BASE>::Table*> RegistrarBase<BASE>::frozen_{nullptr};
+    template<typename BASE>
+    std::atomic<bool> RegistrarBase<BASE>::sealed_{false};
+    template<typename BASE>
+    std::atomic<std::size_t> RegistrarBase<BASE>::rejected_{0};
+    template<typename BASE>
+    std::atomic<std::uint64_t> RegistrarBase<BASE>::version_{1};
 
     /*
      * Derived registrar class.
@@ -87,10 +1490,77 @@ namespace linktimeplugin {
      */
     template<typename PLUGIN>
     class Registrar : public RegistrarBase<typename PLUGIN::Base> {
+    public:
+        // Ctor. The options are passed on to the registrar base class.
+        template<typename... OPTIONS>
+        explicit Registrar(OPTIONS&&... options) noexcept
+        : RegistrarBase<typename PLUGIN::Base>(std::forward<OPTIONS>(options)...) {
+            static_assert(Footprint<PLUGIN>::value <= Limit<typename std::decay<OPTIONS>::type...>::value,
+                "The plug-in class exceeds its budget");
+            static_assert(!Has<Padded, typename std::decay<OPTIONS>::type...>::value,
+                "Only arena plug-ins can be padded");
+            this->template add<PLUGIN>(&plugin_);
+        }
+
+        // Dtor. Unregisters the plug-in before it's destroyed.
+        ~Registrar() {
+            this->remove();
+        }
+
+    private:
         PLUGIN plugin_;
+    };
 
-        typename PLUGIN::Base& operator()() override {
-            return plugin_;
+    /*
+     * Derived registrar class for plug-ins that are constructed on
+     * first use (when they're looked up with find() or enumerated
+     * with plugins()). Until then, the registrar holds uninitialized
+     * storage only (which the OS doesn't map until it's touched), so
+     * startup time and memory depend on the plug-ins that are
+     * actually used.
+     * PLUGIN is the plug-in class (derived from the plug-in base class).
+     */
+    template<typename PLUGIN>
+    class LazyRegistrar : public RegistrarBase<typename PLUGIN::Base> {
+    public:
+        // Ctor. The options are passed on to the registrar base class.
+        template<typename... OPTIONS>
+        explicit LazyRegistrar(OPTIONS&&... options) noexcept
+        : RegistrarBase<typename PLUGIN::Base>(std::forward<OPTIONS>(options)...) {
+            static_assert(Footprint<PLUGIN>::value <= Limit<typename std::decay<OPTIONS>::type...>::value,
+                "The plug-in class exceeds its budget");
+            static_assert(!Has<Padded, typename std::decay<OPTIONS>::type...>::value,
+                "Only arena plug-ins can be padded");
+            this->template add<PLUGIN, &make>(nullptr);
+        }
+
+        ~LazyRegistrar() {
+            this->remove();
+            if (const auto p = instance_.load()) p->~PLUGIN();
+        }
+
+    private:
+        typename std::aligned_storage<sizeof(PLUGIN), alignof(PLUGIN)>::type storage_;
+        std::mutex mutex_;
+        std::atomic<PLUGIN*> instance_{nullptr};
+
+        // Constructs the plug-in exactly once, even if called from
+        // several threads at the same time. If the plug-in's ctor
+        // throws, the instance stays unset and the next call tries
+        // again. (Not std::call_once, which some implementations never
+        // leave again after the function threw.)
+        static typename PLUGIN::Base* make(RegistrarBase<typename PLUGIN::Base>& registrar) {
+            auto& self = static_cast<LazyRegistrar&>(registrar);
+            if (const auto p = self.instance_.load(std::memory_order_acquire)) {
+                return p;
+            }
+            std::lock_guard<std::mutex> lock(self.mutex_);
+            if (const auto p = self.instance_.load(std::memory_order_relaxed)) {
+                return p;
+            }
+            const auto ret = self.template construct<PLUGIN>(&self.storage_);
+            self.instance_.store(ret, std::memory_order_release);
+            return ret;
         }
     };
 
@@ -99,18 +1569,76 @@ namespace linktimeplugin {
      *
      * T is the plug-in base class.
      *
+     * The result is a lightweight, non-owning view of a snapshot
+     * that's built on the first call. Calling this function on a
+     * hot path allocates nothing. Lazy plug-ins are constructed
+     * by the first call.
+     *
      * Example: (MyBase is the plug-in base class, DoSomething is a pure
      * virtual function in the plug-in base class, implemented by the
      * derived plug-in classes)
      *
-     *      for (auto& p : linktimeplugin::plugins<MyBase>()) {
+     *      for (auto p : linktimeplugin::plugins<MyBase>()) {
      *          p->DoSomething();
      *      }
      */
     template<typename T>
-    std::vector<T*> plugins() {
+    Plugins<T> plugins() noexcept {
         return RegistrarBase<T>::plugins();
     }
+
+    /**
+     * Compact the registry of one plug-in base class into a read-only
+     * table.
+     *
+     * T is the plug-in base class.
+     *
+     * Call this once all plug-ins are registered (e. g. at the start
+     * of main, after linktimeplugin::initialize() if you use it). It
+     * constructs all lazy plug-ins and copies the plug-in pointers,
+     * their registrars, their keys, and the key index into a single
+     * memory block. From then on, plugins() and find() read nothing
+     * but this block, without locks. Plug-ins registered later (e. g.
+     * from a library that's loaded at run-time) are rejected and
+     * counted in RegistrarBase<T>::rejected().
+     *
+     * Returns the table, or nullptr if it couldn't be allocated.
+     */
+    template<typename T>
+    const typename RegistrarBase<T>::Table* freeze() noexcept {
+        return RegistrarBase<T>::freeze();
+    }
+
+    /**
+     * Get the plug-in that was registered with the given key.
+     *
+     * T is the plug-in base class. Returns nullptr if no plug-in
+     * was registered with this key. The lookup uses a hash index
+     * that's built during registration; it doesn't allocate. A lazy
+     * plug-in is constructed when it's found for the first time. If
+     * other threads may unregister plug-ins, hold a linktimeplugin::Pin
+     * while using the returned plug-in.
+     *
+     * Example:
+     *
+     *      if (const auto cmd = linktimeplugin::find<Command>(argv[1])) {
+     *          cmd->execute(argc, argv);
+     *      }
+     */
+    template<typename T>
+    T* find(const char* key, std::size_t length) noexcept {
+        return RegistrarBase<T>::find(key, length);
+    }
+
+    template<typename T>
+    T* find(const char* key) noexcept {
+        return RegistrarBase<T>::find(key, std::strlen(key));
+    }
+
+    template<typename T>
+    T* find(const std::string& key) noexcept {
+        return RegistrarBase<T>::find(key.data(), key.size());
+    }
 }
 
 /**
@@ -118,7 +1646,12 @@ namespace linktimeplugin {
  * Use this once for every plug-in class that's derived from the
  * plug-in base class.
  *
- * x is the name of the derived plug-in class.
+ * x is the name of the derived plug-in class. It can be followed by
+ * options (in any order): A string literal that serves as the
+ * plug-in's key for linktimeplugin::find(), the keys of the
+ * plug-ins that this one depends on (linktimeplugin::after()), the
+ * plug-in's size budget in bytes (linktimeplugin::budget<n>()), and
+ * its metadata (linktimeplugin::meta()).
  *
  * Example:
  *
@@ -136,5 +1669,40 @@ namespace linktimeplugin {
  *
  *      // Register the plug-in class
  *      REGISTER_PLUGIN(Plugin);
+ *
+ *      // Or register it with a key, to be found with
+ *      // linktimeplugin::find<PluginBase>("plugin")
+ *      REGISTER_PLUGIN(Plugin, "plugin");
  */
-#define REGISTER_PLUGIN(x) static linktimeplugin::Registrar<x> x##registrar
+#define REGISTER_PLUGIN(...) LINKTIMEPLUGIN_REGISTER(Registrar, __VA_ARGS__)
+
+/**
+ * Register one plug-in class whose instance is constructed on first
+ * use rather than during static initialization. Takes the same
+ * arguments as REGISTER_PLUGIN.
+ *
+ * Example:
+ *
+ *      REGISTER_LAZY_PLUGIN(Plugin, "plugin");
+ */
+#define REGISTER_LAZY_PLUGIN(...) LINKTIMEPLUGIN_REGISTER(LazyRegistrar, __VA_ARGS__)
+
+// Helpers for the REGISTER_... macros. LINKTIMEPLUGIN_ARITY expands to
+// 1 if there's one argument and to N if there are more (up to 8). The
+// options and the descriptor are constants, so the registrar's ctor
+// only stores a pointer to the descriptor.
+#define LINKTIMEPLUGIN_EXPAND(x) x
+#define LINKTIMEPLUGIN_CAT_(a, b) a##b
+#define LINKTIMEPLUGIN_CAT(a, b) LINKTIMEPLUGIN_CAT_(a, b)
+#define LINKTIMEPLUGIN_ARITY_(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define LINKTIMEPLUGIN_ARITY(...) \
+    LINKTIMEPLUGIN_EXPAND(LINKTIMEPLUGIN_ARITY_(__VA_ARGS__, N, N, N, N, N, N, N, 1, ~))
+#define LINKTIMEPLUGIN_REGISTER(r, ...) LINKTIMEPLUGIN_EXPAND( \
+    LINKTIMEPLUGIN_CAT(LINKTIMEPLUGIN_REGISTER_, LINKTIMEPLUGIN_ARITY(__VA_ARGS__))(r, __VA_ARGS__))
+#define LINKTIMEPLUGIN_REGISTER_1(r, x) \
+    LINKTIMEPLUGIN_REGISTER_N(r, x, linktimeplugin::after())
+#define LINKTIMEPLUGIN_REGISTER_N(r, x, ...) \
+    static constexpr auto x##options = linktimeplugin::options( \
+        linktimeplugin::Site{#x, __FILE__, __LINE__}, __VA_ARGS__); \
+    static constexpr linktimeplugin::Descriptor x##registration = linktimeplugin::describe(x##options); \
+    static linktimeplugin::r<x> x##registrar(x##registration, x##options)
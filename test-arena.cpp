@@ -0,0 +1,105 @@
+/**
+ * @brief Link-time plug-in tests: Arena placement
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that the plug-ins registered with REGISTER_ARENA_PLUGIN are
+ * constructed on first use, one after another in one arena in order
+ * of registration, that padded plug-ins get cache lines of their own,
+ * that over-aligned plug-ins are aligned, and that plug-ins registered
+ * later get another arena.
+ */
+
+#include <cstdint>
+#include <memory>
+#include "linktimeplugin-arena.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Counter {
+    public:
+        using Base = Counter;
+        virtual ~Counter() = default;
+        virtual int id() const = 0;
+    };
+
+    int constructed = 0;
+
+    template<int I>
+    class Small : public Counter {
+    public:
+        Small() { ++constructed; }
+        int id() const override { return I; }
+    private:
+        int value_ = 0;
+    };
+    class alignas(128) Wide : public Counter {
+    public:
+        int id() const override { return 128; }
+    };
+    class Late : public Counter {
+    public:
+        int id() const override { return 99; }
+    };
+
+    using Small1 = Small<1>;
+    using Small2 = Small<2>;
+    using Hot = Small<3>;
+    using Small4 = Small<4>;
+
+    std::uintptr_t address(const Counter* p) {
+        return reinterpret_cast<std::uintptr_t>(p);
+    }
+    const Counter& get(const char* key) {
+        return *linktimeplugin::find<Counter>(key);
+    }
+}
+
+REGISTER_ARENA_PLUGIN(Small1, "small1");
+REGISTER_ARENA_PLUGIN(Small2, "small2");
+REGISTER_ARENA_PLUGIN(Hot, "hot", linktimeplugin::padded());
+REGISTER_ARENA_PLUGIN(Small4, "small4");
+REGISTER_ARENA_PLUGIN(Wide, "wide");
+
+int main() {
+    constexpr std::size_t line = linktimeplugin::Arena<Counter>::line;
+
+    // Constructed on first use
+    CHECK(constructed == 0);
+    const auto plugins = linktimeplugin::plugins<Counter>();
+    CHECK(plugins.size() == 5);
+    CHECK(constructed == 4);
+
+    // One after another, in order of registration, starting at a
+    // cache line
+    const auto small1 = address(&get("small1"));
+    const auto small2 = address(&get("small2"));
+    const auto hot = address(&get("hot"));
+    const auto small4 = address(&get("small4"));
+    const auto wide = address(&get("wide"));
+    CHECK(small1 % line == 0);
+    CHECK(small2 == small1 + sizeof(Small2));
+    CHECK(small4 > hot && wide > small4);
+    CHECK(wide - small1 < 4 * line + sizeof(Wide));
+
+    // The padded plug-in has its cache lines to itself
+    CHECK(hot % line == 0);
+    CHECK(small4 == hot + (sizeof(Hot) + line - 1) / line * line);
+
+    // The over-aligned one is aligned
+    CHECK(wide % alignof(Wide) == 0);
+
+    // A plug-in registered later gets another arena
+    {
+        const linktimeplugin::ArenaRegistrar<Late> late("late");
+        const auto p = address(&get("late"));
+        CHECK(p % line == 0);
+        CHECK(p < small1 || p >= wide + sizeof(Wide));
+        CHECK(get("late").id() == 99);
+    }
+    CHECK(linktimeplugin::find<Counter>("late") == nullptr);
+
+    return test::result();
+}
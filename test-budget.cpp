@@ -0,0 +1,79 @@
+/**
+ * @brief Link-time plug-in tests: Size budgets
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Registers plug-ins whose footprint is exactly their budget, with all
+ * registrars that take one, and checks that the budget measures the
+ * registrar without its base class. Built with TEST_OVER_BUDGET, it
+ * registers a plug-in that exceeds its budget, which must not compile
+ * (the budget-over test checks that).
+ */
+
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-arena.hpp"
+#include "linktimeplugin-factory.hpp"
+#include "linktimeplugin-local.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Part {
+    public:
+        using Base = Part;
+        virtual ~Part() = default;
+    };
+
+    // Plug-ins of 64 bytes (with the pointer to the vtable)
+    template<int I>
+    class Plugin : public Part {
+        char data_[64 - sizeof(void*)];
+    };
+
+    using Eager = Plugin<1>;
+    using Lazy = Plugin<2>;
+    using Placed = Plugin<3>;
+    using Spaced = Plugin<4>;
+    using Local = Plugin<5>;
+    using Made = Plugin<6>;
+
+    // A plug-in of 65 bytes, which its alignment pads to 72
+    class Odd : public Part {
+        char data_[65 - sizeof(void*)];
+    };
+
+#ifdef TEST_OVER_BUDGET
+    class Over : public Part {
+        char data_[64];
+    };
+#endif
+}
+
+REGISTER_PLUGIN(Eager, linktimeplugin::budget<64>());
+REGISTER_LAZY_PLUGIN(Lazy, linktimeplugin::budget<64>());
+REGISTER_ARENA_PLUGIN(Placed, linktimeplugin::budget<64>());
+REGISTER_ARENA_PLUGIN(Spaced, linktimeplugin::padded(), linktimeplugin::budget<64>());
+REGISTER_LOCAL_PLUGIN(Local, "local", linktimeplugin::budget<64>());
+REGISTER_FACTORY_PLUGIN(Made, "made", linktimeplugin::budget<64>());
+REGISTER_PLUGIN(Odd, linktimeplugin::budget<72>(), linktimeplugin::budget<100>());
+#ifdef TEST_OVER_BUDGET
+REGISTER_PLUGIN(Over, linktimeplugin::budget<64>());
+#endif
+
+int main() {
+    using linktimeplugin::Footprint;
+    using Registry = linktimeplugin::RegistrarBase<Part>;
+
+    // The budget applies to the registrar without its base class
+    CHECK(Footprint<Eager>::value == 64);
+    CHECK(Footprint<Odd>::value == 72);
+    CHECK(sizeof(linktimeplugin::Registrar<Eager>) - sizeof(Registry) == Footprint<Eager>::value);
+    CHECK(sizeof(linktimeplugin::Registrar<Odd>) - sizeof(Registry) == Footprint<Odd>::value);
+
+    // All plug-ins are there
+    CHECK(linktimeplugin::plugins<Part>().size() == 6);
+    CHECK(linktimeplugin::create<Part>("made") != nullptr);
+
+    return test::result();
+}
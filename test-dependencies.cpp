@@ -0,0 +1,102 @@
+/**
+ * @brief Link-time plug-in tests: Dependency-aware initialization
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::initialize() initializes the plug-ins
+ * that a plug-in depends on before it, and that it leaves out the
+ * plug-ins whose dependencies are missing or form a cycle, and the
+ * plug-ins that depend on them.
+ */
+
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Stage {
+    public:
+        using Base = Stage;
+        virtual ~Stage() = default;
+    };
+
+    // The keys of the plug-ins in the order their init() hooks ran
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    // Position of a key in the order, or -1 if its init() didn't run
+    int position(const char* key) {
+        const auto it = std::find(order.begin(), order.end(), key);
+        return it == order.end() ? -1 : static_cast<int>(it - order.begin());
+    }
+
+    // Plug-in that records when its init() runs. The classes differ
+    // by the index of their key only.
+    const char* const keys[] = {
+        "tables", "lexer", "parser", "compiler", "solo",
+        "a", "b", "c", "orphan", "child"
+    };
+    template<int I>
+    class Recorder : public Stage {
+    public:
+        void init() {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(keys[I]);
+        }
+    };
+
+    // A diamond: compiler needs parser and lexer, which both need tables
+    using Tables = Recorder<0>;
+    using Lexer = Recorder<1>;
+    using Parser = Recorder<2>;
+    using Compiler = Recorder<3>;
+    using Solo = Recorder<4>;
+
+    // A cycle (a and b), and a plug-in that depends on it (c)
+    using A = Recorder<5>;
+    using B = Recorder<6>;
+    using C = Recorder<7>;
+
+    // A missing dependency, and a plug-in that depends on its victim
+    using Orphan = Recorder<8>;
+    using Child = Recorder<9>;
+}
+
+// Registered in an order that doesn't match the dependencies
+REGISTER_PLUGIN(Compiler, "compiler", linktimeplugin::after("parser", "lexer"));
+REGISTER_LAZY_PLUGIN(Parser, "parser", linktimeplugin::after("tables"));
+REGISTER_PLUGIN(Lexer, "lexer", linktimeplugin::after("tables"));
+REGISTER_LAZY_PLUGIN(Tables, "tables");
+REGISTER_PLUGIN(Solo, "solo");
+REGISTER_PLUGIN(A, "a", linktimeplugin::after("b"));
+REGISTER_PLUGIN(B, "b", linktimeplugin::after("a"));
+REGISTER_PLUGIN(C, "c", linktimeplugin::after("a"));
+REGISTER_PLUGIN(Orphan, "orphan", linktimeplugin::after("nowhere"));
+REGISTER_PLUGIN(Child, "child", linktimeplugin::after("orphan"));
+
+int main() {
+    CHECK(linktimeplugin::initialize<Stage>(4) == 5);
+    CHECK(order.size() == 5);
+
+    // Dependencies first
+    CHECK(position("tables") >= 0);
+    CHECK(position("tables") < position("lexer"));
+    CHECK(position("tables") < position("parser"));
+    CHECK(position("lexer") < position("compiler"));
+    CHECK(position("parser") < position("compiler"));
+    CHECK(position("solo") >= 0);
+
+    // Cycles and missing dependencies fail, and so do their dependents
+    for (const auto key : { "a", "b", "c", "orphan", "child" }) {
+        CHECK(position(key) == -1);
+        CHECK(linktimeplugin::find<Stage>(key) == nullptr);
+    }
+    CHECK(linktimeplugin::plugins<Stage>().size() == 5);
+
+    return test::result();
+}
@@ -0,0 +1,128 @@
+/**
+ * @brief Link-time plug-in tests: Factory plug-ins
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that the plug-ins registered with REGISTER_FACTORY_PLUGIN get
+ * a new instance per linktimeplugin::create(), initialized with init(),
+ * and that released instances are recycled: reset and reused if the
+ * plug-in class has a reset() hook, destroyed and reconstructed in place
+ * if not.
+ */
+
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "linktimeplugin-factory.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Job {
+    public:
+        using Base = Job;
+        virtual ~Job() = default;
+        virtual int step() = 0;
+    };
+
+    int constructed = 0, destroyed = 0, resets = 0, inits = 0;
+
+    // Keeps its state between uses, until reset()
+    class Reusable : public Job {
+    public:
+        Reusable() { ++constructed; }
+        ~Reusable() { ++destroyed; }
+        void init() { ++inits; }
+        void reset() {
+            steps_ = 0;
+            ++resets;
+        }
+        int step() override { return ++steps_; }
+    private:
+        int steps_ = 0;
+    };
+
+    // Fails to initialize
+    class Unready : public Job {
+    public:
+        Unready() { ++constructed; }
+        ~Unready() { ++destroyed; }
+        void init() { throw std::runtime_error("unready"); }
+        int step() override { return 0; }
+    };
+
+    // Destroyed on release, over-aligned
+    class alignas(128) Disposable : public Job {
+    public:
+        Disposable() { ++constructed; }
+        ~Disposable() { ++destroyed; }
+        int step() override { return ++steps_; }
+    private:
+        int steps_ = 0;
+    };
+}
+
+REGISTER_FACTORY_PLUGIN(Reusable, "reusable");
+REGISTER_FACTORY_PLUGIN(Disposable, "disposable");
+REGISTER_FACTORY_PLUGIN(Unready, "unready");
+
+int main() {
+    // Every create() makes another instance
+    {
+        const auto a = linktimeplugin::create<Job>("reusable");
+        const auto b = linktimeplugin::create<Job>("reusable");
+        CHECK(a && b && a.get() != b.get());
+        CHECK(constructed == 2);
+        CHECK(inits == 2);
+        CHECK(a->step() == 1 && a->step() == 2);
+    }
+    CHECK(!linktimeplugin::create<Job>("missing"));
+
+    // Released instances were reset, and are reused as they are
+    CHECK(resets == 2);
+    CHECK(destroyed == 0);
+    {
+        const auto c = linktimeplugin::create<Job>("reusable");
+        CHECK(constructed == 2);
+        CHECK(inits == 2);
+        CHECK(c->step() == 1);
+    }
+
+    // Instances without reset() are destroyed on release, and a new one
+    // is constructed in the same memory
+    Job* first;
+    {
+        const auto d = linktimeplugin::create<Job>("disposable");
+        first = d.get();
+        CHECK(reinterpret_cast<std::uintptr_t>(first) % alignof(Disposable) == 0);
+        d->step();
+    }
+    CHECK(destroyed == 1);
+    {
+        const auto e = linktimeplugin::create<Job>("disposable");
+        CHECK(e.get() == first);
+        CHECK(e->step() == 1);
+    }
+    CHECK(constructed == 4);
+
+    // An instance whose init() throws is destroyed
+    CHECK(!linktimeplugin::create<Job>("unready"));
+    CHECK(constructed == 5);
+    CHECK(destroyed == 3);
+
+    // The factories are plug-ins themselves
+    CHECK(linktimeplugin::plugins<linktimeplugin::Factory<Job>>().size() == 3);
+
+    // Instances released on other threads are recycled there, and
+    // destroyed when the thread ends
+    const auto before = destroyed;
+    std::thread([] {
+        std::vector<linktimeplugin::Instance<Job>> all;
+        for (auto i = 0; i < 10; ++i) all.push_back(linktimeplugin::create<Job>("reusable"));
+    }).join();
+    CHECK(destroyed == before + 10);
+
+    return test::result();
+}
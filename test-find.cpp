@@ -0,0 +1,101 @@
+/**
+ * @brief Link-time plug-in tests: Lookup by key
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::find() finds the plug-ins by their keys,
+ * finds nothing for other keys, and returns the first registration of
+ * a key that was registered more than once.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Tool {
+    public:
+        using Base = Tool;
+        virtual ~Tool() = default;
+        virtual int id() const = 0;
+    };
+
+    template<int I>
+    class Plugin : public Tool {
+        int id() const override { return I; }
+    };
+
+    using Hammer = Plugin<1>;
+    using Saw = Plugin<2>;
+    using Drill = Plugin<3>;
+    using Other = Plugin<4>;
+    using Anonymous = Plugin<5>;
+    using Numbered = Plugin<6>;
+}
+
+REGISTER_PLUGIN(Hammer, "hammer");
+REGISTER_LAZY_PLUGIN(Saw, "saw");
+REGISTER_PLUGIN(Drill, "drill");
+REGISTER_PLUGIN(Other, "drill");
+REGISTER_PLUGIN(Anonymous);
+
+int main() {
+    using linktimeplugin::find;
+    using Registry = linktimeplugin::RegistrarBase<Tool>;
+
+    // Hits, with all overloads; a lazy plug-in is constructed on lookup
+    CHECK(find<Tool>("hammer") && find<Tool>("hammer")->id() == 1);
+    CHECK(find<Tool>("saw") && find<Tool>("saw")->id() == 2);
+    CHECK(find<Tool>(std::string("hammer")) == find<Tool>("hammer"));
+    CHECK(find<Tool>("hammering", 6) == find<Tool>("hammer"));
+    CHECK(Registry::registrar("saw", 3) && Registry::registrar("saw", 3)->key() == std::string("saw"));
+
+    // Misses: Unknown keys, prefixes and extensions of known ones
+    CHECK(find<Tool>("missing") == nullptr);
+    CHECK(find<Tool>("") == nullptr);
+    CHECK(find<Tool>("ham") == nullptr);
+    CHECK(find<Tool>("hammers") == nullptr);
+    CHECK(find<Tool>("Hammer") == nullptr);
+    CHECK(Registry::registrar("missing", 7) == nullptr);
+
+    // The first registration of a duplicate key wins; the other one is
+    // still a plug-in
+    CHECK(find<Tool>("drill") && find<Tool>("drill")->id() == 3);
+    CHECK(linktimeplugin::plugins<Tool>().size() == 5);
+
+    // Keys registered at run time, enough to grow the index
+    std::vector<std::string> keys;
+    for (auto i = 0; i < 100; ++i) keys.push_back("tool" + std::to_string(i));
+    std::vector<std::unique_ptr<linktimeplugin::Registrar<Numbered>>> registrars;
+    for (const auto& k : keys) {
+        registrars.emplace_back(new linktimeplugin::Registrar<Numbered>(k.c_str()));
+    }
+    auto found = 0;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (find<Tool>(keys[i]) == registrars[i]->get()) ++found;
+    }
+    CHECK(found == 100);
+    CHECK(find<Tool>("tool100") == nullptr);
+    CHECK(find<Tool>("hammer") && find<Tool>("hammer")->id() == 1);
+
+    // A duplicate registered at run time doesn't replace the first one;
+    // once the first one is unregistered, the duplicate is found
+    std::unique_ptr<linktimeplugin::Registrar<Numbered>> again(
+        new linktimeplugin::Registrar<Numbered>(keys[0].c_str()));
+    CHECK(find<Tool>(keys[0]) == registrars[0]->get());
+    registrars[0].reset();
+    CHECK(find<Tool>(keys[0]) == again->get());
+
+    // Unregistered keys aren't found anymore
+    again.reset();
+    registrars.clear();
+    CHECK(find<Tool>(keys[0]) == nullptr);
+    CHECK(find<Tool>(keys[99]) == nullptr);
+    CHECK(find<Tool>("saw") && find<Tool>("saw")->id() == 2);
+
+    return test::result();
+}
@@ -0,0 +1,27 @@
+# Link-time plug-ins
+# Test of the static footprint report
+# by agent 2026-10-16
+#
+# Usage: cmake -DNM=nm -DBINARY=test-footprint -DOUTPUT=report.txt
+#              -P test-footprint.cmake
+#
+# Writes the footprint report of test-footprint (see
+# linktimeplugin-footprint.cmake) and checks the sizes in it, which
+# have zeros in them.
+
+execute_process(
+    COMMAND ${CMAKE_COMMAND} -DNM=${NM} -DBINARY=${BINARY} -DOUTPUT=${OUTPUT}
+        -P ${CMAKE_CURRENT_LIST_DIR}/linktimeplugin-footprint.cmake
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0 OR NOT EXISTS ${OUTPUT})
+    message(FATAL_ERROR "No footprint report")
+endif()
+
+file(READ ${OUTPUT} report)
+foreach(expected "2 plug-ins, 3072 bytes" "\n      2048  Huge\n" "\n      1024  Large\n")
+    string(FIND "${report}" "${expected}" found)
+    if(found EQUAL -1)
+        message(FATAL_ERROR "Not in the footprint report: \"${expected}\"")
+    endif()
+endforeach()
@@ -0,0 +1,38 @@
+/**
+ * @brief Link-time plug-in tests: Footprint report
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Plug-ins whose registrars are 1024 and 2048 bytes, sizes with zeros
+ * in them, for test-footprint.cmake, which checks the footprint report
+ * of this program. The alignment of the plug-ins fixes the size of
+ * their registrars, whatever the size of the registrar base class.
+ */
+
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Block {
+    public:
+        using Base = Block;
+        virtual ~Block() = default;
+    };
+
+    class alignas(512) Large : public Block {
+    };
+    class alignas(1024) Huge : public Block {
+    };
+}
+
+REGISTER_PLUGIN(Large);
+REGISTER_PLUGIN(Huge);
+
+int main() {
+    CHECK(sizeof(linktimeplugin::Registrar<Large>) == 1024);
+    CHECK(sizeof(linktimeplugin::Registrar<Huge>) == 2048);
+    CHECK(linktimeplugin::plugins<Block>().size() == 2);
+    return test::result();
+}
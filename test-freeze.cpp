@@ -0,0 +1,113 @@
+/**
+ * @brief Link-time plug-in tests: Frozen registry
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::freeze() constructs the lazy plug-ins,
+ * copies the registry into a table that plugins() and find() use, and
+ * rejects later registrations, and that plug-ins that fail afterwards
+ * are left out of the table.
+ */
+
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Shape {
+    public:
+        using Base = Shape;
+        virtual ~Shape() = default;
+        virtual int corners() const = 0;
+    };
+
+    class Triangle : public Shape {
+        int corners() const override { return 3; }
+    };
+    class Square : public Shape {
+        int corners() const override { return 4; }
+    };
+    class Broken : public Shape {
+    public:
+        Broken() { throw std::runtime_error("broken"); }
+        int corners() const override { return -1; }
+    };
+    class Pentagon : public Shape {
+        int corners() const override { return 5; }
+    };
+    class Hexagon : public Shape {
+        int corners() const override { return 6; }
+    };
+    class Faulty : public Shape {
+    public:
+        void init() { throw std::runtime_error("faulty"); }
+        int corners() const override { return 7; }
+    };
+}
+
+REGISTER_PLUGIN(Triangle, "triangle");
+REGISTER_LAZY_PLUGIN(Square, "square");
+REGISTER_LAZY_PLUGIN(Broken, "broken");
+REGISTER_PLUGIN(Faulty, "faulty");
+
+int main() {
+    // Registered at run time, before the registry is frozen
+    std::unique_ptr<linktimeplugin::Registrar<Pentagon>> pentagon(
+        new linktimeplugin::Registrar<Pentagon>("pentagon"));
+
+    // The table lists the plug-ins that could be constructed, in
+    // order of registration
+    const auto table = linktimeplugin::freeze<Shape>();
+    CHECK(table != nullptr);
+    if (!table) return test::result();
+    CHECK(table->size == 4);
+    CHECK(table->plugins[0]->corners() == 3);
+    CHECK(table->plugins[1]->corners() == 4);
+    CHECK(table->plugins[2]->corners() == 7);
+    CHECK(table->plugins[3]->corners() == 5);
+    CHECK(std::strcmp(table->keys[1], "square") == 0);
+    CHECK(table->registrars[1]->get() == table->plugins[1]);
+    CHECK(linktimeplugin::freeze<Shape>() == table);
+
+    // plugins() and find() use the table
+    const auto plugins = linktimeplugin::plugins<Shape>();
+    CHECK(plugins.size() == 4);
+    CHECK(plugins.begin() == table->plugins);
+    CHECK(linktimeplugin::find<Shape>("square") == table->plugins[1]);
+    CHECK(linktimeplugin::find<Shape>("broken") == nullptr);
+    CHECK(linktimeplugin::find<Shape>("circle") == nullptr);
+
+    // Registrations are rejected from now on
+    {
+        const linktimeplugin::Registrar<Hexagon> hexagon("hexagon");
+        CHECK(hexagon.failed());
+        CHECK(linktimeplugin::RegistrarBase<Shape>::rejected() == 1);
+        CHECK(linktimeplugin::find<Shape>("hexagon") == nullptr);
+        CHECK(linktimeplugin::plugins<Shape>().size() == 4);
+    }
+
+    // A plug-in whose init() fails is left out of a new table
+    CHECK(linktimeplugin::initialize<Shape>(2) == 3);
+    const auto refrozen = linktimeplugin::freeze<Shape>();
+    CHECK(refrozen != nullptr);
+    if (refrozen) CHECK(refrozen->size == 3);
+    const auto left = linktimeplugin::plugins<Shape>();
+    CHECK(left.size() == 3);
+    for (const auto p : left) CHECK(p->corners() != 7);
+    CHECK(linktimeplugin::find<Shape>("faulty") == nullptr);
+    CHECK(linktimeplugin::find<Shape>("square") && linktimeplugin::find<Shape>("square")->corners() == 4);
+    CHECK(linktimeplugin::RegistrarBase<Shape>::rejected() == 1);
+
+    // Unregistering drops the table
+    pentagon.reset();
+    CHECK(linktimeplugin::plugins<Shape>().size() == 2);
+    CHECK(linktimeplugin::find<Shape>("pentagon") == nullptr);
+    CHECK(linktimeplugin::find<Shape>("triangle")->corners() == 3);
+
+    return test::result();
+}
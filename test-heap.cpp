@@ -0,0 +1,142 @@
+/**
+ * @brief Link-time plug-in tests: Heap accounting
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Built with LINKTIMEPLUGIN_HEAP. Checks that the bytes that a plug-in
+ * allocates in its ctor, in its init() hook, and in calls through
+ * linktimeplugin::for_each() are booked on its account, that memory
+ * freed elsewhere is booked back on it, and that allocations and
+ * deallocations of untagged code don't change any account.
+ */
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-heap.hpp"
+#include "linktimeplugin-metrics.hpp"
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+LINKTIMEPLUGIN_HEAP_HOOKS();
+
+namespace {
+    // Plug-in base class
+    class Store {
+    public:
+        using Base = Store;
+        virtual ~Store() = default;
+        virtual void work() {}
+    };
+
+    // Allocates 1000 bytes in its ctor, 500 in init(), 100 per call
+    class Cache : public Store {
+    public:
+        Cache() : buffer_(1000) {}
+        void init() { table_.reset(new char[500]); }
+        void work() override { last_.reset(new char[100]); }
+        void drop() { table_.reset(); }
+    private:
+        std::vector<char> buffer_;
+        std::unique_ptr<char[]> table_;
+        std::unique_ptr<char[]> last_;
+    };
+
+    // Allocates 200 bytes when it's constructed, on first use
+    class Idle : public Store {
+    public:
+        Idle() : buffer_(200) {}
+    private:
+        std::vector<char> buffer_;
+    };
+
+    using linktimeplugin::heap::Account;
+    using linktimeplugin::heap::Usage;
+
+    // Returns the registrar of a plug-in by its class name
+    linktimeplugin::RegistrarBase<Store>* registrar(const char* name) {
+        for (const auto r : linktimeplugin::RegistrarBase<Store>::registrars()) {
+            if (std::strcmp(r->site().name, name) == 0) return r;
+        }
+        return nullptr;
+    }
+
+    // Returns true if two snapshots of the accounts are the same
+    bool same(const std::vector<Usage>& a, const std::vector<Usage>& b) {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (a[i].name != b[i].name || a[i].live != b[i].live || a[i].peak != b[i].peak
+                || a[i].allocations != b[i].allocations || a[i].deallocations != b[i].deallocations) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+REGISTER_PLUGIN(Cache);
+REGISTER_LAZY_PLUGIN(Idle);
+
+int main() {
+    const auto registrar = ::registrar("Cache");
+    CHECK(registrar != nullptr);
+    if (!registrar) return test::result();
+    const Account* const cache = registrar->account();
+    const Account* const idle = ::registrar("Idle") ? ::registrar("Idle")->account() : nullptr;
+    CHECK(cache && idle);
+    if (!cache || !idle) return test::result();
+
+    // The ctor of the eager plug-in ran with its account tagged; the
+    // lazy one hasn't been constructed yet
+    CHECK(cache->live == 1000 && cache->peak == 1000 && cache->allocations == 1);
+    CHECK(idle->live == 0 && idle->allocations == 0);
+    CHECK(linktimeplugin::heap::current() == nullptr);
+
+    // Allocations and deallocations of untagged code aren't booked
+    const auto before = linktimeplugin::heap::accounts();
+    {
+        std::unique_ptr<char[]> block(new char[4096]);
+        std::string text(300, 'x');
+        std::vector<int> numbers(100, 1);
+    }
+    CHECK(same(before, linktimeplugin::heap::accounts()));
+
+    // init() runs with the account tagged, also on the pool threads;
+    // constructing the lazy plug-in books its ctor's allocations
+    CHECK(linktimeplugin::initialize<Store>(2) == 2);
+    CHECK(cache->live == 1500 && cache->peak == 1500 && cache->allocations == 2);
+    CHECK(idle->live == 200 && idle->allocations == 1);
+
+    // Memory freed by untagged code is booked back on the account it
+    // was allocated on
+    const auto plugin = static_cast<Cache*>(registrar->get());
+    CHECK(plugin != nullptr);
+    if (!plugin) return test::result();
+    plugin->drop();
+    CHECK(cache->live == 1000 && cache->peak == 1500 && cache->deallocations == 1);
+    CHECK(idle->live == 200 && idle->deallocations == 0);
+
+    // Calls through for_each() are booked; a direct call isn't, but
+    // the memory it frees is booked back
+    linktimeplugin::for_each<Store>([](Store* p) { p->work(); });
+    CHECK(cache->live == 1100 && cache->allocations == 3);
+    CHECK(idle->live == 200 && idle->allocations == 1);
+    plugin->work();
+    CHECK(cache->live == 1000 && cache->allocations == 3 && cache->deallocations == 2);
+    plugin->work();
+    CHECK(cache->live == 1000 && cache->allocations == 3 && cache->deallocations == 2);
+
+    // The report lists the plug-in with the most live bytes first
+    std::ostringstream os;
+    linktimeplugin::heap::report(os);
+    const auto report = os.str();
+    CHECK(report.find("Plug-in heap report: 2 plug-ins\n") == 0);
+    CHECK(report.find("          1000          1500           3           1  Cache\n") != std::string::npos);
+    CHECK(report.find("Cache") < report.find("Idle"));
+
+    return test::result();
+}
@@ -0,0 +1,98 @@
+/**
+ * @brief Link-time plug-in tests: Parallel initialization
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::initialize() constructs every plug-in and
+ * runs every init() hook exactly once on the worker threads, and that
+ * it leaves out the plug-ins whose ctor or init() throws.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Task {
+    public:
+        using Base = Task;
+        virtual ~Task() = default;
+        virtual bool ready() const = 0;
+    };
+
+    // How often init() ran, and on which threads
+    std::atomic<int> inits{0};
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+
+    // Plug-in whose init() takes some time, so that the pool spreads
+    // the plug-ins over its threads
+    template<int I>
+    class Slow : public Task {
+    public:
+        void init() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ++inits;
+            ready_ = true;
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        }
+        bool ready() const override { return ready_; }
+    private:
+        bool ready_ = false;
+    };
+
+    // Plug-ins that fail
+    class BadInit : public Task {
+    public:
+        void init() { throw std::runtime_error("init"); }
+        bool ready() const override { return true; }
+    };
+    class BadCtor : public Task {
+    public:
+        BadCtor() { throw std::runtime_error("ctor"); }
+        bool ready() const override { return true; }
+    };
+
+    using Slow0 = Slow<0>;
+    using Slow1 = Slow<1>;
+    using Slow2 = Slow<2>;
+    using Slow3 = Slow<3>;
+}
+
+REGISTER_PLUGIN(Slow0, "slow0");
+REGISTER_PLUGIN(Slow1, "slow1");
+REGISTER_LAZY_PLUGIN(Slow2, "slow2");
+REGISTER_LAZY_PLUGIN(Slow3, "slow3");
+REGISTER_PLUGIN(BadInit, "bad-init");
+REGISTER_LAZY_PLUGIN(BadCtor, "bad-ctor");
+
+int main() {
+    CHECK(linktimeplugin::initialize<Task>(4) == 4);
+    CHECK(inits == 4);
+    CHECK(threads.size() > 1);
+
+    // Only the plug-ins that are ready are left
+    const linktimeplugin::Pin pin;
+    const auto plugins = linktimeplugin::plugins<Task>();
+    CHECK(plugins.size() == 4);
+    for (const auto p : plugins) {
+        CHECK(p->ready());
+    }
+    CHECK(linktimeplugin::find<Task>("bad-init") == nullptr);
+    CHECK(linktimeplugin::find<Task>("bad-ctor") == nullptr);
+    CHECK(linktimeplugin::find<Task>("slow3") != nullptr);
+
+    // A second run doesn't run the hooks again
+    CHECK(linktimeplugin::initialize<Task>() == 4);
+    CHECK(inits == 4);
+
+    return test::result();
+}
@@ -0,0 +1,148 @@
+/**
+ * @brief Link-time plug-in tests: Per-thread plug-in instances
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that the plug-ins registered with REGISTER_LOCAL_PLUGIN have
+ * an instance per thread, initialized with init(), and that the
+ * instances are merged into the shared one when a thread ends or calls
+ * linktimeplugin::local::flush().
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "linktimeplugin-local.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Meter {
+    public:
+        using Base = Meter;
+        virtual ~Meter() = default;
+        virtual void hit() = 0;
+        virtual long total() const = 0;
+    };
+
+    std::atomic<int> inits{0};
+
+    // Per-thread plug-in that adds up its hits when merged
+    class Local : public Meter {
+    public:
+        void init() {
+            ready_ = true;
+            ++inits;
+        }
+        void merge(Local& other) {
+            hits_ += other.hits_;
+        }
+        void hit() override {
+            if (ready_) ++hits_;
+        }
+        long total() const override { return hits_; }
+    private:
+        bool ready_ = false;
+        long hits_ = 0;
+    };
+
+    // Per-thread plug-in whose ctor uses the calling thread's instance
+    // of another one
+    std::atomic<int> peers{0};
+    class Lookup : public Meter {
+    public:
+        Lookup() {
+            if (linktimeplugin::local::find<Meter>("local")) ++peers;
+        }
+        void hit() override {}
+        long total() const override { return 0; }
+    };
+
+    // Per-thread plug-in whose first construction (the shared instance)
+    // fails
+    std::atomic<int> constructions{0};
+    class Flaky : public Meter {
+    public:
+        Flaky() {
+            if (constructions++ == 0) throw std::runtime_error("flaky");
+        }
+        void hit() override {}
+        long total() const override { return 0; }
+    };
+
+    // Shared plug-in, for comparison
+    class Shared : public Meter {
+    public:
+        void hit() override { ++hits_; }
+        long total() const override { return hits_; }
+    private:
+        std::atomic<long> hits_{0};
+    };
+}
+
+REGISTER_LOCAL_PLUGIN(Local, "local");
+REGISTER_LOCAL_PLUGIN(Lookup, "lookup");
+REGISTER_LOCAL_PLUGIN(Flaky, "flaky");
+REGISTER_PLUGIN(Shared, "shared");
+
+int main() {
+    constexpr auto threads = 4;
+    constexpr auto hits = 1000;
+
+    // No instance for the thread without a shared one to merge into;
+    // the next use constructs both
+    CHECK(linktimeplugin::local::find<Meter>("flaky") == nullptr);
+    CHECK(constructions == 1);
+    const auto flaky = linktimeplugin::local::find<Meter>("flaky");
+    CHECK(flaky != nullptr && flaky != linktimeplugin::find<Meter>("flaky"));
+    CHECK(constructions == 3);
+
+    // The shared instance, initialized like any other
+    const auto shared = linktimeplugin::find<Meter>("local");
+    CHECK(shared != nullptr);
+    if (!shared) return test::result();
+    CHECK(linktimeplugin::RegistrarBase<Meter>::registrar("local", 5)->initialize());
+    CHECK(inits == 1);
+
+    // Every thread hits its own instances; half of them flush halfway
+    std::vector<std::thread> pool;
+    std::atomic<int> distinct{0};
+    for (auto t = 0; t < threads; ++t) {
+        pool.emplace_back([t, shared, &distinct] {
+            const auto own = linktimeplugin::local::find<Meter>("local");
+            if (own && own != shared) ++distinct;
+            for (auto i = 0; i < hits; ++i) {
+                for (const auto p : linktimeplugin::local::plugins<Meter>()) {
+                    p->hit();
+                }
+                if (t % 2 && i == hits / 2) linktimeplugin::local::flush();
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+    CHECK(distinct == threads);
+
+    // Merged when the threads ended; every instance ran init(), so
+    // none of the hits was lost
+    CHECK(shared->total() == threads * hits);
+    CHECK(linktimeplugin::find<Meter>("shared")->total() == threads * hits);
+    CHECK(inits == 1 + threads + threads / 2);
+
+    // The main thread has an instance of its own, too
+    const auto own = linktimeplugin::local::find<Meter>("local");
+    CHECK(own != nullptr && own != shared);
+    own->hit();
+    CHECK(shared->total() == threads * hits);
+    linktimeplugin::local::flush();
+    CHECK(shared->total() == threads * hits + 1);
+
+    // Merging the instances of a thread that ends doesn't construct
+    // anything, so the ctor of a shared instance never runs while the
+    // instances are locked
+    std::thread([] { linktimeplugin::local::find<Meter>("lookup"); }).join();
+    CHECK(peers > 0);
+
+    return test::result();
+}
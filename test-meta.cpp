@@ -0,0 +1,115 @@
+/**
+ * @brief Link-time plug-in tests: Metadata of the plug-ins
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that the metadata given with linktimeplugin::meta() can be
+ * queried through the registrars without constructing lazy plug-ins,
+ * that plug-ins without metadata are named by their class name, and
+ * that meta() is a compile-time constant.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Animal {
+    public:
+        using Base = Animal;
+        virtual ~Animal() = default;
+
+        // Capabilities
+        static constexpr std::uint64_t pet = 1;
+        static constexpr std::uint64_t swims = 2;
+        static constexpr std::uint64_t flies = 4;
+    };
+
+    int constructed = 0;
+
+    class Cat : public Animal {
+    public:
+        Cat() { ++constructed; }
+    };
+    class Duck : public Animal {
+    public:
+        Duck() { ++constructed; }
+    };
+    class Plain : public Animal {
+    };
+    class Unnamed : public Animal {
+    };
+
+    // Returns the registrar of a plug-in by its metadata name
+    const linktimeplugin::RegistrarBase<Animal>* named(const char* name) {
+        for (const auto r : linktimeplugin::RegistrarBase<Animal>::registrars()) {
+            if (r->meta().name && std::strcmp(r->meta().name, name) == 0) return r;
+        }
+        return nullptr;
+    }
+
+    // meta() is usable in constant expressions
+    constexpr auto fish = linktimeplugin::meta("Fish", 3, -1, Animal::swims);
+    static_assert(fish.length == 4, "Length of the name");
+    static_assert(fish.version == 3 && fish.priority == -1, "Version and priority");
+    static_assert(fish.has(Animal::swims) && !fish.has(Animal::swims | Animal::pet), "Capabilities");
+    static_assert(linktimeplugin::meta("").length == 0 && linktimeplugin::meta("").flags == 0,
+        "Defaults");
+}
+
+REGISTER_LAZY_PLUGIN(Cat, "cat", linktimeplugin::meta("Kitty", 2, 10, Animal::pet));
+REGISTER_LAZY_PLUGIN(Duck, linktimeplugin::meta("Duck", 1, 5, Animal::swims | Animal::flies));
+REGISTER_PLUGIN(Plain);
+
+int main() {
+    // The metadata is there without constructing the lazy plug-ins
+    const auto cat = named("Kitty");
+    const auto duck = named("Duck");
+    CHECK(cat && duck);
+    CHECK(constructed == 0);
+    if (cat) {
+        CHECK(cat->meta().length == 5);
+        CHECK(cat->meta().version == 2 && cat->meta().priority == 10);
+        CHECK(cat->meta().has(Animal::pet) && !cat->meta().has(Animal::swims));
+        CHECK(cat->key() == std::string("cat"));
+    }
+    if (duck) {
+        CHECK(duck->meta().version == 1 && duck->meta().priority == 5);
+        CHECK(duck->meta().has(Animal::swims | Animal::flies));
+        CHECK(!duck->meta().has(Animal::swims | Animal::pet));
+        CHECK(duck->meta().has(0));
+    }
+    CHECK(constructed == 0);
+
+    // Given metadata replaces the class name
+    CHECK(named("Cat") == nullptr);
+    if (cat) CHECK(cat->site().name == std::string("Cat"));
+
+    // Without metadata, the name is the class name and everything else is 0
+    const auto plain = named("Plain");
+    CHECK(plain);
+    if (plain) {
+        CHECK(plain->meta().length == 5);
+        CHECK(plain->meta().version == 0 && plain->meta().priority == 0);
+        CHECK(plain->meta().flags == 0 && plain->meta().has(0));
+    }
+
+    // A registrar constructed without the macros has neither a name nor
+    // a site, unless it's given metadata
+    std::unique_ptr<linktimeplugin::Registrar<Unnamed>> unnamed(new linktimeplugin::Registrar<Unnamed>);
+    CHECK(unnamed->meta().name == nullptr && unnamed->meta().length == 0);
+    std::unique_ptr<linktimeplugin::Registrar<Unnamed>> fishy(new linktimeplugin::Registrar<Unnamed>(fish));
+    CHECK(named("Fish") == fishy.get());
+    CHECK(fishy->meta().has(Animal::swims));
+
+    // Looking up a lazy plug-in constructs it; its metadata stays the same
+    CHECK(linktimeplugin::find<Animal>("cat") && constructed == 1);
+    if (cat) CHECK(cat->meta().version == 2);
+
+    return test::result();
+}
@@ -0,0 +1,148 @@
+/**
+ * @brief Link-time plug-in tests: Call metrics
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks the buckets of the latency histogram around every power of
+ * two, the percentiles that linktimeplugin::metrics::collect() derives
+ * from a known distribution of call durations, and the format of
+ * linktimeplugin::metrics::report().
+ */
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-metrics.hpp"
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class, with metrics enabled
+    class Handler {
+    public:
+        using Base = Handler;
+        static constexpr bool metrics = true;
+        virtual ~Handler() = default;
+        virtual void handle() {}
+    };
+
+    class Fast : public Handler {
+    };
+    class Slow : public Handler {
+    };
+    class Idle : public Handler {
+    };
+}
+
+REGISTER_PLUGIN(Fast, "fast");
+REGISTER_PLUGIN(Slow, "slow");
+REGISTER_PLUGIN(Idle);
+
+int main() {
+    using linktimeplugin::metrics::Histogram;
+    using Registry = linktimeplugin::RegistrarBase<Handler>;
+
+    // Below 16, every value has a bucket of its own
+    for (std::uint64_t v = 0; v < 16; ++v) {
+        CHECK(Histogram::bucket(v) == v && Histogram::highest(v) == v);
+    }
+
+    // Every bucket holds the values above the highest value of the
+    // bucket before it, up to its own highest value; from 16 on, it's
+    // at most 1/16th as wide as its values; every power of two starts
+    // a bucket
+    auto buckets = 0, bounds = 0, widths = 0, starts = 0;
+    for (unsigned e = 4; e < Histogram::magnitudes; ++e) {
+        const auto power = std::uint64_t(1) << e;
+        for (const auto v : {power - 1, power, power + 1, power + power / 2, power * 2 - 1}) {
+            const auto b = Histogram::bucket(v);
+            if (b < 1 || b >= Histogram::size) {
+                ++buckets;
+                continue;
+            }
+            if (!(Histogram::highest(b - 1) < v && v <= Histogram::highest(b))) ++bounds;
+            if (v >= 16 && (Histogram::highest(b) - Histogram::highest(b - 1)) * 16 > v) ++widths;
+        }
+        if (Histogram::highest(Histogram::bucket(power) - 1) != power - 1) ++starts;
+    }
+    CHECK(buckets == 0);
+    CHECK(bounds == 0);
+    CHECK(widths == 0);
+    CHECK(starts == 0);
+
+    // The buckets of the first powers of two, and the last bucket,
+    // which also holds the longer calls
+    CHECK(Histogram::bucket(16) == 16 && Histogram::highest(16) == 16);
+    CHECK(Histogram::bucket(32) == 32 && Histogram::highest(32) == 33);
+    CHECK(Histogram::bucket((std::uint64_t(1) << 40) - 1) == Histogram::size - 1);
+    CHECK(Histogram::bucket(std::uint64_t(1) << 40) == Histogram::size - 1);
+    CHECK(Histogram::bucket(~std::uint64_t(0)) == Histogram::size - 1);
+
+    // Known durations: 1 to 1000 ns for one plug-in, a million times
+    // 10 us and one call of 1 ms for the other
+    const auto fast = Registry::registrar("fast", 4);
+    const auto slow = Registry::registrar("slow", 4);
+    CHECK(fast && slow);
+    if (!fast || !slow) return test::result();
+    for (std::uint64_t ns = 1; ns <= 1000; ++ns) {
+        linktimeplugin::metrics::record<Handler>(fast->id(), ns);
+    }
+    for (auto i = 0; i < 999; ++i) {
+        linktimeplugin::metrics::record<Handler>(slow->id(), 10000);
+    }
+    linktimeplugin::metrics::record<Handler>(slow->id(), 1000000);
+
+    // The percentiles are the highest value of the bucket that the
+    // value of their rank falls into, and not above the maximum
+    const auto all = linktimeplugin::metrics::collect<Handler>();
+    CHECK(all.size() == 2);
+    if (all.size() != 2) return test::result();
+    const auto& f = all[0];
+    CHECK(f.name == "fast");
+    CHECK(f.calls == 1000 && f.total == 500500 && f.max == 1000);
+    CHECK(f.p50 == Histogram::highest(Histogram::bucket(500)));
+    CHECK(f.p50 >= 500 && f.p50 <= 500 + 500 / 16);
+    CHECK(f.p90 == Histogram::highest(Histogram::bucket(900)));
+    CHECK(f.p99 == Histogram::highest(Histogram::bucket(990)));
+    CHECK(f.p999 == 1000);
+    const auto& s = all[1];
+    CHECK(s.name == "slow");
+    CHECK(s.calls == 1000 && s.max == 1000000);
+    CHECK(s.p50 == Histogram::highest(Histogram::bucket(10000)));
+    CHECK(s.p99 == s.p50);
+    CHECK(s.p999 == s.p50);
+
+    // Calls through for_each() are counted, also of plug-ins that
+    // weren't called before, which are named by their class name
+    linktimeplugin::for_each<Handler>([](Handler* p) { p->handle(); });
+    const auto counted = linktimeplugin::metrics::collect<Handler>();
+    CHECK(counted.size() == 3);
+    if (counted.size() == 3) {
+        CHECK(counted[0].calls == 1001 && counted[1].calls == 1001);
+        CHECK(counted[2].name == "Idle" && counted[2].calls == 1);
+    }
+
+    // The report: A header and one line per plug-in, the one with the
+    // most time spent in it first, times in microseconds; the total of
+    // the slow one includes the call through for_each(), and 10000 ns
+    // fall into the bucket up to 10239 ns
+    std::ostringstream os;
+    linktimeplugin::metrics::report<Handler>(os);
+    std::istringstream is(os.str());
+    std::string header, first, second, third, end;
+    std::getline(is, header);
+    std::getline(is, first);
+    std::getline(is, second);
+    std::getline(is, third);
+    CHECK(header == "       calls    total us   mean us    p50 us    p99 us  p99.9 us    max us  plug-in");
+    CHECK(first.size() == header.size() - 7 + 4);
+    CHECK(first.compare(0, 19, "        1001     10") == 0);
+    CHECK(first.compare(first.size() - 56, 56, "      11.0      10.2      10.2      10.2    1000.0  slow") == 0);
+    CHECK(second.substr(second.size() - 6) == "  fast");
+    CHECK(third.substr(third.size() - 6) == "  Idle");
+    CHECK(!std::getline(is, end));
+
+    return test::result();
+}
@@ -0,0 +1,133 @@
+/**
+ * @brief Link-time plug-in tests: Parallel broadcast
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::for_each() and reduce() call every
+ * plug-in exactly once with either policy, that reduce() combines the
+ * results in plug-in order, and that exceptions reach the caller. Also
+ * with a plug-in base class that has metrics enabled, whose dispatch
+ * goes through the registrars.
+ */
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include "linktimeplugin-parallel.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base classes, without and with metrics
+    class Worker {
+    public:
+        using Base = Worker;
+        virtual ~Worker() = default;
+        virtual char name() const = 0;
+        std::atomic<int> calls{0};
+    };
+    class Measured {
+    public:
+        using Base = Measured;
+        static constexpr bool metrics = true;
+        virtual ~Measured() = default;
+        virtual char name() const = 0;
+        std::atomic<int> calls{0};
+    };
+
+    // Plug-in classes, named by a letter
+    template<typename BASE, char NAME>
+    class Letter : public BASE {
+        char name() const override { return NAME; }
+    };
+    class Failing : public Measured {
+    public:
+        void init() { throw std::runtime_error("init"); }
+        char name() const override { return '!'; }
+    };
+
+    using WorkerA = Letter<Worker, 'a'>;
+    using WorkerB = Letter<Worker, 'b'>;
+    using WorkerC = Letter<Worker, 'c'>;
+    using WorkerD = Letter<Worker, 'd'>;
+    using WorkerE = Letter<Worker, 'e'>;
+    using MeasuredX = Letter<Measured, 'x'>;
+    using MeasuredY = Letter<Measured, 'y'>;
+
+    // Calls every plug-in of a base class with a policy, and checks
+    // that each one was called once
+    template<typename T, typename POLICY>
+    void broadcast(POLICY policy, std::size_t count) {
+        for (const auto p : linktimeplugin::plugins<T>()) p->calls = 0;
+        std::atomic<std::size_t> visited{0};
+        linktimeplugin::for_each<T>(policy, [&](T* p) {
+            ++p->calls;
+            ++visited;
+        });
+        CHECK(visited == count);
+        for (const auto p : linktimeplugin::plugins<T>()) CHECK(p->calls == 1);
+    }
+
+    // Concatenates the plug-ins' names with a policy
+    template<typename T, typename POLICY>
+    std::string names(POLICY policy) {
+        return linktimeplugin::reduce<T>(policy, std::string(),
+            [](T* p) { return std::string(1, p->name()); },
+            [](std::string a, std::string b) { return a + b; });
+    }
+}
+
+REGISTER_PLUGIN(WorkerA);
+REGISTER_LAZY_PLUGIN(WorkerB);
+REGISTER_PLUGIN(WorkerC);
+REGISTER_LAZY_PLUGIN(WorkerD);
+REGISTER_PLUGIN(WorkerE);
+REGISTER_PLUGIN(MeasuredX, "x");
+REGISTER_PLUGIN(Failing, "failing");
+REGISTER_PLUGIN(MeasuredY, "y");
+
+int main() {
+    CHECK(linktimeplugin::initialize<Measured>() == 2);
+
+    for (auto round = 0; round < 100; ++round) {
+        broadcast<Worker>(linktimeplugin::serial, 5);
+        broadcast<Worker>(linktimeplugin::parallel, 5);
+        broadcast<Worker>(linktimeplugin::Parallel{2}, 5);
+        broadcast<Measured>(linktimeplugin::parallel, 2);
+
+        // In plug-in order, whatever the policy
+        CHECK(names<Worker>(linktimeplugin::serial) == "abcde");
+        CHECK(names<Worker>(linktimeplugin::parallel) == "abcde");
+        CHECK(names<Measured>(linktimeplugin::parallel) == "xy");
+    }
+
+    // Broadcasts from within a broadcast run in the calling thread
+    std::atomic<int> inner{0};
+    linktimeplugin::for_each<Worker>(linktimeplugin::parallel, [&](Worker*) {
+        linktimeplugin::for_each<Measured>(linktimeplugin::parallel, [&](Measured*) { ++inner; });
+    });
+    CHECK(inner == 10);
+
+    // The first exception reaches the caller
+    std::atomic<int> calls{0};
+    auto thrown = false;
+    try {
+        linktimeplugin::for_each<Worker>(linktimeplugin::parallel, [&](Worker* p) {
+            ++calls;
+            if (p->name() == 'c') throw std::runtime_error("c");
+        });
+    } catch(const std::runtime_error& e) {
+        thrown = std::string(e.what()) == "c";
+    }
+    CHECK(thrown);
+    CHECK(calls >= 1 && calls <= 5);
+
+    // The metrics count the calls of the plug-ins that didn't fail
+    const auto metrics = linktimeplugin::metrics::collect<Measured>();
+    CHECK(metrics.size() == 2);
+    for (const auto& m : metrics) {
+        CHECK(m.calls == 100 * 2 + 5);
+    }
+
+    return test::result();
+}
@@ -0,0 +1,104 @@
+/**
+ * @brief Link-time plug-in tests: Perfect hash table of the keys
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Built with linktimeplugin_perfect_hash(), which generates a perfect
+ * hash table over the keys registered in this file. Checks that every
+ * key has a slot of its own that round-trips to the key, that other
+ * keys are rejected, and that linktimeplugin::find() finds the plug-ins
+ * through the table as well as keys that are registered at run time.
+ */
+
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Codec {
+    public:
+        using Base = Codec;
+        virtual ~Codec() = default;
+        virtual int id() const = 0;
+    };
+
+    template<int I>
+    class Plugin : public Codec {
+        int id() const override { return I; }
+    };
+
+    using Alpha = Plugin<1>;
+    using Beta = Plugin<2>;
+    using Gamma = Plugin<3>;
+    using Delta = Plugin<4>;
+    using Epsilon = Plugin<5>;
+    using Again = Plugin<6>;
+    using Late = Plugin<7>;
+
+    // Returns the slot of a key in the table (size if it's not there)
+    std::size_t slot(const char* key) {
+        const auto length = std::strlen(key);
+        return linktimeplugin::perfect_hash.find(key, length, linktimeplugin::hash(key, length));
+    }
+}
+
+REGISTER_PLUGIN(Alpha, "alpha");
+REGISTER_PLUGIN(Beta, "beta");
+REGISTER_LAZY_PLUGIN(Gamma, "gamma");
+REGISTER_PLUGIN(Delta, "delta");
+REGISTER_PLUGIN(Epsilon, "epsilon");
+REGISTER_PLUGIN(Again, "alpha");
+
+int main() {
+    using linktimeplugin::find;
+    const auto& table = linktimeplugin::perfect_hash;
+
+    // Every key of this file, once
+    CHECK(table.size == 5);
+
+    // Every registered key has a slot of its own, which holds the key
+    std::vector<bool> taken(table.size);
+    auto keys = 0;
+    for (const auto r : linktimeplugin::RegistrarBase<Codec>::registrars()) {
+        const auto s = slot(r->key());
+        CHECK(s < table.size);
+        if (s >= table.size) continue;
+        CHECK(std::strcmp(table.keys[s], r->key()) == 0);
+        CHECK(table.lengths[s] == std::strlen(r->key()));
+        if (!taken[s]) ++keys;
+        taken[s] = true;
+    }
+    CHECK(keys == 5);
+
+    // Other keys are rejected, including ones of the same length
+    CHECK(slot("missing") == table.size);
+    CHECK(slot("alphb") == table.size);
+    CHECK(slot("") == table.size);
+
+    // find() goes through the table; the first registration of a key wins
+    CHECK(find<Codec>("alpha") && find<Codec>("alpha")->id() == 1);
+    CHECK(find<Codec>("beta") && find<Codec>("beta")->id() == 2);
+    CHECK(find<Codec>("gamma") && find<Codec>("gamma")->id() == 3);
+    CHECK(find<Codec>("delta") && find<Codec>("delta")->id() == 4);
+    CHECK(find<Codec>("epsilon") && find<Codec>("epsilon")->id() == 5);
+    CHECK(find<Codec>("missing") == nullptr);
+
+    // A key registered at run time isn't in the table, but it's found
+    std::unique_ptr<linktimeplugin::Registrar<Late>> late(new linktimeplugin::Registrar<Late>("late"));
+    CHECK(slot("late") == table.size);
+    CHECK(find<Codec>("late") && find<Codec>("late")->id() == 7);
+    late.reset();
+    CHECK(find<Codec>("late") == nullptr);
+
+    // A key of the table whose plug-in is registered again at run time
+    std::unique_ptr<linktimeplugin::Registrar<Late>> beta(new linktimeplugin::Registrar<Late>("beta"));
+    CHECK(find<Codec>("beta") && find<Codec>("beta")->id() == 2);
+    beta.reset();
+    CHECK(find<Codec>("beta") && find<Codec>("beta")->id() == 2);
+
+    return test::result();
+}
@@ -0,0 +1,144 @@
+/**
+ * @brief Link-time plug-in tests: Startup profile
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Built with LINKTIMEPLUGIN_PROFILE. Checks that every registrar adds
+ * one record with the plug-in's name, the source location of its
+ * registration, and whether it's lazy, that the construction and the
+ * init() hook are timed when they run, and that the report lists the
+ * records slowest first.
+ */
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-parallel.hpp"
+#include "linktimeplugin-profile.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Part {
+    public:
+        using Base = Part;
+        virtual ~Part() = default;
+    };
+
+    class Quick : public Part {
+    };
+    class Slow : public Part {
+    public:
+        Slow() { std::this_thread::sleep_for(std::chrono::milliseconds(20)); }
+    };
+    class Later : public Part {
+    };
+    class Prepared : public Part {
+    public:
+        void init() { std::this_thread::sleep_for(std::chrono::milliseconds(10)); }
+    };
+    class Late : public Part {
+    };
+
+    using linktimeplugin::profile::Record;
+
+    // Returns a copy of the records
+    std::vector<Record> records() {
+        std::lock_guard<std::mutex> lock(linktimeplugin::profile::mutex());
+        const auto& r = linktimeplugin::profile::records();
+        return std::vector<Record>(r.begin(), r.end());
+    }
+
+    // Returns the line of the report of a plug-in
+    std::string line(const std::string& report, const std::string& name) {
+        std::istringstream is(report);
+        std::string ret;
+        while (std::getline(is, ret)) {
+            if (ret.find("  " + name + " (") != std::string::npos) return ret;
+        }
+        return "";
+    }
+}
+
+// The lines of the registrations
+constexpr int quick = __LINE__ + 5;
+constexpr int slow = quick + 1;
+constexpr int later = quick + 2;
+constexpr int prepared = quick + 3;
+
+REGISTER_PLUGIN(Quick, "quick");
+REGISTER_PLUGIN(Slow, "slow");
+REGISTER_LAZY_PLUGIN(Later, "later");
+REGISTER_PLUGIN(Prepared, "prepared");
+
+int main() {
+    std::unique_ptr<linktimeplugin::Registrar<Late>> late(new linktimeplugin::Registrar<Late>("late"));
+
+    // One record per registrar, in order of registration
+    auto r = records();
+    CHECK(r.size() == 5);
+    if (r.size() != 5) return test::result();
+    const struct {
+        const char* name;
+        int line;
+        bool lazy;
+    } expected[] = {{"Quick", quick, false}, {"Slow", slow, false}, {"Later", later, true}, {"Prepared", prepared, false}};
+    for (std::size_t i = 0; i < 4; ++i) {
+        CHECK(r[i].name == expected[i].name);
+        CHECK(r[i].file && std::strcmp(r[i].file, __FILE__) == 0);
+        CHECK(r[i].line == expected[i].line);
+        CHECK(r[i].lazy == expected[i].lazy);
+    }
+
+    // A registrar constructed without the macros has no source
+    // location; it's named by its class
+    CHECK(r[4].name.find("Late") != std::string::npos);
+    CHECK(r[4].file == nullptr && !r[4].lazy);
+
+    // The eager plug-ins were constructed during static initialization,
+    // the lazy one wasn't; no init() hook ran yet
+    CHECK(r[0].construction >= 0 && r[0].constructed >= 0);
+    CHECK(r[1].construction >= 20000000 && r[1].constructed >= r[0].constructed);
+    CHECK(r[2].construction == -1 && r[2].constructed == -1);
+    for (const auto& e : r) CHECK(e.init == -1);
+    std::ostringstream before;
+    linktimeplugin::profile::report(before);
+    CHECK(line(before.str(), "Later").find(") lazy, not constructed") != std::string::npos);
+
+    // Constructing the lazy plug-in and running the init() hooks
+    // records their times
+    CHECK(linktimeplugin::initialize<Part>() == 5);
+    r = records();
+    CHECK(r[2].construction >= 0 && r[2].constructed >= r[1].constructed);
+    CHECK(r[3].init >= 10000000);
+    CHECK(r[0].init == -1 && r[3].total() == r[3].construction + r[3].init);
+
+    // The report: The slowest plug-in first, with the source location
+    // of its registration
+    std::ostringstream os;
+    linktimeplugin::profile::report(os);
+    const auto report = os.str();
+    std::istringstream is(report);
+    std::string title, header, first, second;
+    std::getline(is, title);
+    std::getline(is, header);
+    std::getline(is, first);
+    std::getline(is, second);
+    CHECK(title.find("Plug-in startup report: 5 plug-ins, ") == 0);
+    CHECK(header == "  start us    total us  construct us   init us  plug-in");
+    const auto location = std::string(" (") + __FILE__ + ':';
+    CHECK(first.find("  Slow" + location + std::to_string(slow) + ')') != std::string::npos);
+    CHECK(second.find("  Prepared" + location + std::to_string(prepared) + ')') != std::string::npos);
+    CHECK(second.find("         -  Prepared") == std::string::npos);
+    CHECK(line(report, "Later").find(location + std::to_string(later) + ") lazy") != std::string::npos);
+    CHECK(report.find("not constructed") == std::string::npos);
+
+    return test::result();
+}
@@ -0,0 +1,20 @@
+/**
+ * @brief Link-time plug-in tests: Linker section registration, plug-ins
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#include "test-section.hpp"
+
+namespace {
+    class Deflate : public Codec {
+        int id() const override { return 2; }
+    };
+    class Blur : public Filter {
+        int id() const override { return 10; }
+    };
+}
+
+REGISTER_SECTION_PLUGIN(Deflate, "deflate");
+REGISTER_SECTION_PLUGIN(Blur, "blur");
@@ -0,0 +1,67 @@
+/**
+ * @brief Link-time plug-in tests: Linker section registration
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that the plug-ins registered with REGISTER_SECTION_PLUGIN in
+ * several translation units are found through the linker section, by
+ * plug-in base class and by key, and that each is constructed once.
+ */
+
+#include <set>
+#include "test-section.hpp"
+#include "test.hpp"
+
+namespace {
+    int constructed = 0;
+
+    class Identity : public Codec {
+    public:
+        Identity() { ++constructed; }
+        int id() const override { return 1; }
+    };
+    class Unnamed : public Codec {
+        int id() const override { return 3; }
+    };
+    class Sharpen : public Filter {
+        int id() const override { return 11; }
+    };
+}
+
+REGISTER_SECTION_PLUGIN(Identity, "identity");
+REGISTER_SECTION_PLUGIN(Unnamed);
+REGISTER_SECTION_PLUGIN(Sharpen, "sharpen");
+
+int main() {
+    // Nothing is constructed before it's used
+    CHECK(constructed == 0);
+
+    // The plug-ins of each base class, from both translation units
+    std::set<int> codecs, filters;
+    for (const auto p : linktimeplugin::section::plugins<Codec>()) {
+        codecs.insert(p->id());
+    }
+    for (const auto p : linktimeplugin::section::plugins<Filter>()) {
+        filters.insert(p->id());
+    }
+    CHECK(codecs == (std::set<int>{1, 2, 3}));
+    CHECK(filters == (std::set<int>{10, 11}));
+    CHECK(constructed == 1);
+
+    // Lookup by key, within the base class only
+    const auto identity = linktimeplugin::section::find<Codec>("identity");
+    CHECK(identity && identity->id() == 1);
+    CHECK(linktimeplugin::section::find<Codec>("deflate")->id() == 2);
+    CHECK(linktimeplugin::section::find<Filter>("blur")->id() == 10);
+    CHECK(linktimeplugin::section::find<Codec>("blur") == nullptr);
+    CHECK(linktimeplugin::section::find<Codec>("missing") == nullptr);
+
+    // The instances are constructed once
+    for (const auto p : linktimeplugin::section::plugins<Codec>()) {
+        if (p->id() == 1) CHECK(p == identity);
+    }
+    CHECK(constructed == 1);
+
+    return test::result();
+}
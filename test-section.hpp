@@ -0,0 +1,26 @@
+/**
+ * @brief Link-time plug-in tests: Linker section registration
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include "linktimeplugin-section.hpp"
+
+// Plug-in base classes. Their plug-ins are registered in two
+// translation units, so the linker has to collect the descriptors.
+class Codec {
+public:
+    using Base = Codec;
+    virtual ~Codec() = default;
+    virtual int id() const = 0;
+};
+
+class Filter {
+public:
+    using Base = Filter;
+    virtual ~Filter() = default;
+    virtual int id() const = 0;
+};
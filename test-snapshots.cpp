@@ -0,0 +1,148 @@
+/**
+ * @brief Link-time plug-in tests: Registry snapshots
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that threads can enumerate and look up plug-ins while another
+ * thread registers and unregisters eager and lazy ones, that a Pin
+ * keeps a view valid, and that the retired snapshots are freed. Run it
+ * in a build with -DLINKTIMEPLUGIN_SANITIZE=thread or address to find
+ * races and uses of freed snapshots or plug-ins.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Node {
+    public:
+        using Base = Node;
+        virtual ~Node() = default;
+        virtual int value() const = 0;
+    };
+
+    // The value of every plug-in until it's destroyed
+    constexpr int alive = 42;
+
+    template<int I>
+    class Plugin : public Node {
+    public:
+        ~Plugin() { value_.store(0); }
+        int value() const override { return value_.load(); }
+    private:
+        std::atomic<int> value_{alive};
+    };
+
+    using Fixed = Plugin<0>;
+    using Eager = Plugin<1>;
+    using Lazy = Plugin<2>;
+
+    // Keys of the plug-ins registered at run time
+    const char* const keys[] = {
+        "dynamic0", "dynamic1", "dynamic2", "dynamic3",
+        "dynamic4", "dynamic5", "dynamic6", "dynamic7",
+    };
+    constexpr std::size_t count = sizeof(keys) / sizeof(keys[0]);
+}
+
+REGISTER_PLUGIN(Fixed, "fixed");
+
+int main() {
+    using linktimeplugin::plugins;
+    using linktimeplugin::find;
+
+    // A pinned view stays valid while another thread changes the
+    // registry; the old snapshot is retired, not freed
+    std::unique_ptr<linktimeplugin::Registrar<Eager>> late;
+    {
+        const linktimeplugin::Pin pin;
+        const auto before = plugins<Node>();
+        CHECK(before.size() == 1);
+        std::thread([&late] { late.reset(new linktimeplugin::Registrar<Eager>("late")); }).join();
+        CHECK(plugins<Node>().size() == 2);
+        CHECK(before.size() == 1 && before[0]->value() == alive);
+        std::lock_guard<std::mutex> lock(linktimeplugin::epoch::mutex());
+        CHECK(!linktimeplugin::epoch::retired().empty());
+    }
+    CHECK(find<Node>("late") == late.get()->get());
+    late.reset();
+    CHECK(find<Node>("late") == nullptr);
+    CHECK(plugins<Node>().size() == 1);
+
+    // Readers that hold a pin while they enumerate and look up
+    constexpr auto readers = 4;
+    constexpr auto rounds = 30;
+    std::atomic<bool> stop{false};
+    std::atomic<long> reads{0}, errors{0};
+    std::vector<std::thread> pool;
+    for (auto t = 0; t < readers; ++t) {
+        pool.emplace_back([&] {
+            while (!stop) {
+                const linktimeplugin::Pin pin;
+                const auto all = plugins<Node>();
+                if (all.empty()) ++errors;
+                for (const auto p : all) {
+                    if (p->value() != alive) ++errors;
+                }
+                for (const auto r : linktimeplugin::RegistrarBase<Node>::registrars()) {
+                    if (!r->key()) ++errors;
+                }
+                for (const auto k : keys) {
+                    const auto p = find<Node>(k);
+                    if (p && p->value() != alive) ++errors;
+                }
+                if (!find<Node>("fixed") || find<Node>("missing")) ++errors;
+                ++reads;
+            }
+        });
+    }
+
+    // The writer registers eager and lazy plug-ins, sometimes with a
+    // key that's taken, and unregisters them in reverse order (which
+    // shares the arrays of the snapshots) or in order of registration
+    // (which builds them from scratch). Every round waits until the
+    // readers read the registry while it holds the plug-ins.
+    for (auto r = 0; r < rounds; ++r) {
+        std::vector<std::shared_ptr<void>> registrars;
+        for (std::size_t i = 0; i < count / 2; ++i) {
+            registrars.push_back(std::make_shared<linktimeplugin::Registrar<Eager>>(keys[i]));
+            registrars.push_back(std::make_shared<linktimeplugin::LazyRegistrar<Lazy>>(keys[count / 2 + i]));
+        }
+        if (r % 3 == 0) {
+            registrars.push_back(std::make_shared<linktimeplugin::LazyRegistrar<Lazy>>(keys[0]));
+        }
+        const auto seen = reads.load();
+        while (reads < seen + readers) std::this_thread::yield();
+        if (r % 2) {
+            while (!registrars.empty()) registrars.pop_back();
+        } else {
+            while (!registrars.empty()) registrars.erase(registrars.begin());
+        }
+    }
+    stop = true;
+    for (auto& t : pool) t.join();
+    CHECK(reads >= rounds * readers);
+    CHECK(errors == 0);
+
+    // Only the plug-in registered at startup is left, and no snapshot
+    // is waiting to be freed once no thread is pinned
+    CHECK(plugins<Node>().size() == 1);
+    for (const auto k : keys) {
+        CHECK(find<Node>(k) == nullptr);
+    }
+    {
+        std::lock_guard<std::mutex> lock(linktimeplugin::epoch::mutex());
+        linktimeplugin::epoch::reclaim();
+        CHECK(linktimeplugin::epoch::retired().empty());
+    }
+
+    return test::result();
+}
@@ -0,0 +1,317 @@
+/**
+ * @brief Link-time plug-in tests: Trace events
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Built with LINKTIMEPLUGIN_TRACE and small ring buffers. Registers and
+ * calls plug-ins from two threads and checks that the file written by
+ * linktimeplugin::trace::flush() parses as JSON and holds their
+ * registration, construction, and call events, that the rings of the
+ * threads that ended are freed, and that flushing while another thread
+ * records, overwriting its ring, still writes valid JSON.
+ */
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "linktimeplugin.hpp"
+#include "linktimeplugin-parallel.hpp"
+#include "linktimeplugin-trace.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Job {
+    public:
+        using Base = Job;
+        virtual ~Job() = default;
+        virtual void run() {}
+    };
+
+    class Alpha : public Job {
+    };
+    class Beta : public Job {
+    };
+    class Gamma : public Job {
+    };
+    class Delta : public Job {
+    };
+
+    /*
+     * A JSON value, as far as the trace needs it
+     */
+    struct Value {
+        enum Type { null, boolean, number, string, array, object } type = null;
+        double n = 0;
+        std::string s;
+        std::vector<Value> items;
+        std::map<std::string, Value> members;
+
+        // Returns a member of an object (null if there's none)
+        const Value& operator[](const std::string& key) const {
+            static const Value none;
+            const auto i = members.find(key);
+            return i != members.end() ? i->second : none;
+        }
+    };
+
+    /*
+     * Parses JSON text. Sets ok to false if it isn't valid JSON.
+     */
+    class Parser {
+    public:
+        explicit Parser(const std::string& text) : text_(text) {}
+
+        Value parse() {
+            auto ret = value();
+            space();
+            if (pos_ != text_.size()) ok = false;
+            return ret;
+        }
+
+        bool ok = true;
+
+    private:
+        void space() {
+            while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) ++pos_;
+        }
+        bool next(char c) {
+            space();
+            if (pos_ < text_.size() && text_[pos_] == c) {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+        bool literal(const char* word) {
+            const std::string w(word);
+            if (text_.compare(pos_, w.size(), w) != 0) return false;
+            pos_ += w.size();
+            return true;
+        }
+
+        Value value() {
+            Value ret;
+            space();
+            if (!ok || pos_ >= text_.size()) {
+                ok = false;
+            } else if (next('{')) {
+                ret.type = Value::object;
+                if (next('}')) return ret;
+                do {
+                    space();
+                    const auto key = string();
+                    if (!next(':')) ok = false;
+                    if (!ok) return ret;
+                    ret.members[key] = value();
+                } while (ok && next(','));
+                if (!next('}')) ok = false;
+            } else if (next('[')) {
+                ret.type = Value::array;
+                if (next(']')) return ret;
+                do {
+                    ret.items.push_back(value());
+                } while (ok && next(','));
+                if (!next(']')) ok = false;
+            } else if (text_[pos_] == '"') {
+                ret.type = Value::string;
+                ret.s = string();
+            } else if (literal("true") || literal("false")) {
+                ret.type = Value::boolean;
+            } else if (literal("null")) {
+                ret.type = Value::null;
+            } else {
+                ret.type = Value::number;
+                const auto start = text_.c_str() + pos_;
+                char* end = nullptr;
+                ret.n = std::strtod(start, &end);
+                if (end == start) ok = false;
+                pos_ += static_cast<std::size_t>(end - start);
+            }
+            return ret;
+        }
+
+        std::string string() {
+            std::string ret;
+            if (pos_ >= text_.size() || text_[pos_] != '"') {
+                ok = false;
+                return ret;
+            }
+            for (++pos_; pos_ < text_.size() && text_[pos_] != '"'; ++pos_) {
+                if (static_cast<unsigned char>(text_[pos_]) < 0x20) ok = false;
+                if (text_[pos_] == '\\' && ++pos_ == text_.size()) break;
+                ret += text_[pos_];
+            }
+            if (pos_ >= text_.size()) ok = false;
+            ++pos_;
+            return ret;
+        }
+
+        const std::string text_;
+        std::size_t pos_ = 0;
+    };
+
+    // Flushes the trace events to a file and returns them, checking
+    // that the file is valid JSON and that every event is complete
+    std::vector<Value> flush() {
+        const char* const path = "test-trace.json";
+        CHECK(linktimeplugin::trace::flush(path));
+        std::ifstream file(path);
+        std::ostringstream text;
+        text << file.rdbuf();
+        file.close();
+        std::remove(path);
+
+        Parser parser(text.str());
+        const auto trace = parser.parse();
+        CHECK(parser.ok);
+        CHECK(trace["displayTimeUnit"].s == "ns");
+        const auto& events = trace["traceEvents"];
+        CHECK(events.type == Value::array);
+        for (const auto& e : events.items) {
+            CHECK(e["name"].type == Value::string && !e["name"].s.empty());
+            CHECK(e["ph"].s == "X" || (e["ph"].s == "i" && e["s"].s == "t"));
+            CHECK(e["ph"].s == "i" || e["dur"].n >= 0);
+            CHECK(e["ts"].type == Value::number && e["ts"].n >= 0);
+            CHECK(e["tid"].type == Value::number);
+            CHECK(e["args"]["base"].s.find("Job") != std::string::npos);
+        }
+        return events.items;
+    }
+
+    // Returns the threads that recorded events of a category for a
+    // plug-in whose name contains the given one
+    std::set<double> threads(const std::vector<Value>& events, const char* category, const char* name) {
+        std::set<double> ret;
+        for (const auto& e : events) {
+            if (e["cat"].s == category && e["name"].s.find(name) != std::string::npos) ret.insert(e["tid"].n);
+        }
+        return ret;
+    }
+
+    // Returns the number of threads that have a ring buffer
+    std::size_t rings() {
+        std::lock_guard<std::mutex> lock(linktimeplugin::trace::mutex());
+        return linktimeplugin::trace::rings().size();
+    }
+
+    // Registers a plug-in, calls all plug-ins a few times once the
+    // other thread has registered its plug-in, too, and unregisters it
+    // once the other thread is done calling
+    template<typename PLUGIN>
+    void work(const char* key, std::promise<void>& registered, std::shared_future<void> both,
+    std::promise<void>& called, std::shared_future<void> all) {
+        const linktimeplugin::Registrar<PLUGIN> registrar(key);
+        registered.set_value();
+        both.wait();
+        for (auto i = 0; i < 5; ++i) {
+            linktimeplugin::for_each<Job>([](Job* p) { p->run(); });
+        }
+        called.set_value();
+        all.wait();
+    }
+}
+
+static_assert(linktimeplugin::trace::Ring::size == 64, "Built with small rings");
+
+REGISTER_PLUGIN(Alpha, "alpha");
+REGISTER_LAZY_PLUGIN(Beta, "beta");
+
+int main() {
+    // Two threads register a plug-in each, and call all plug-ins once
+    // both are registered; the threads end before the flush
+    {
+        std::promise<void> gamma, delta, both, a_called, b_called, all;
+        const auto registered = both.get_future().share();
+        const auto called = all.get_future().share();
+        std::thread a(work<Gamma>, "gamma", std::ref(gamma), registered, std::ref(a_called), called);
+        std::thread b(work<Delta>, "delta", std::ref(delta), registered, std::ref(b_called), called);
+        gamma.get_future().wait();
+        delta.get_future().wait();
+        both.set_value();
+        a_called.get_future().wait();
+        b_called.get_future().wait();
+        all.set_value();
+        a.join();
+        b.join();
+    }
+    CHECK(rings() == 3);
+    const auto events = flush();
+    CHECK(rings() == 1);
+
+    // The registrations, each on the thread that registered
+    const auto startup = threads(events, "registration", "Alpha");
+    const auto gamma = threads(events, "registration", "Gamma");
+    const auto delta = threads(events, "registration", "Delta");
+    CHECK(startup.size() == 1 && gamma.size() == 1 && delta.size() == 1);
+    CHECK(threads(events, "registration", "Beta") == startup);
+    CHECK(gamma != startup && delta != startup && gamma != delta);
+
+    // The calls of all plug-ins, on both threads; the lazy plug-in was
+    // constructed by one of them
+    std::set<double> both(gamma);
+    both.insert(delta.begin(), delta.end());
+    CHECK(threads(events, "call", "Alpha") == both);
+    CHECK(threads(events, "call", "Beta") == both);
+    CHECK(threads(events, "call", "Gamma") == both);
+    CHECK(threads(events, "call", "Delta") == both);
+    const auto constructed = threads(events, "construction", "Beta");
+    CHECK(constructed.size() == 1 && both.count(*constructed.begin()) == 1);
+    CHECK(threads(events, "construction", "Alpha") == startup);
+
+    // The events of the threads that ended were written once; the
+    // ones of the main thread are written again
+    const auto again = flush();
+    CHECK(threads(again, "registration", "Alpha") == startup);
+    CHECK(threads(again, "call", "Alpha").empty());
+
+    // Flushing while another thread records and overwrites its ring
+    {
+        std::atomic<bool> stop{false};
+        std::atomic<int> rounds{0};
+        std::thread writer([&] {
+            while (!stop.load()) {
+                linktimeplugin::for_each<Job>([](Job* p) { p->run(); });
+                ++rounds;
+            }
+        });
+        while (rounds.load() < 100) std::this_thread::yield();
+        for (auto i = 0; i < 20; ++i) {
+            CHECK(flush().size() <= 2 * linktimeplugin::trace::Ring::size);
+        }
+        stop.store(true);
+        writer.join();
+    }
+    flush();
+    CHECK(rings() == 1);
+
+    // A thread whose events were written frees its ring when it ends
+    {
+        std::promise<void> recorded, flushed;
+        const auto done = flushed.get_future();
+        std::thread t([&] {
+            linktimeplugin::for_each<Job>([](Job* p) { p->run(); });
+            recorded.set_value();
+            done.wait();
+        });
+        recorded.get_future().wait();
+        CHECK(rings() == 2);
+        CHECK(threads(flush(), "call", "Alpha").size() == 1);
+        flushed.set_value();
+        t.join();
+        CHECK(rings() == 1);
+    }
+
+    return test::result();
+}
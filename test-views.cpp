@@ -0,0 +1,105 @@
+/**
+ * @brief Link-time plug-in tests: Views of the plug-ins
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ *
+ * Checks that linktimeplugin::plugins() returns the plug-ins in order
+ * of registration as a view of the registry's snapshot, which stays the
+ * same until the registry changes, and that lazy and failed plug-ins
+ * are listed or left out as they should be.
+ */
+
+#include <memory>
+#include <stdexcept>
+#include "linktimeplugin.hpp"
+#include "test.hpp"
+
+namespace {
+    // Plug-in base class
+    class Item {
+    public:
+        using Base = Item;
+        virtual ~Item() = default;
+        virtual int number() const = 0;
+    };
+
+    int lazies = 0;
+
+    class First : public Item {
+        int number() const override { return 1; }
+    };
+    class Second : public Item {
+    public:
+        Second() { ++lazies; }
+        int number() const override { return 2; }
+    };
+    class Broken : public Item {
+    public:
+        Broken() { throw std::runtime_error("broken"); }
+        int number() const override { return -1; }
+    };
+    class Third : public Item {
+        int number() const override { return 3; }
+    };
+    class Fourth : public Item {
+        int number() const override { return 4; }
+    };
+}
+
+REGISTER_PLUGIN(First);
+REGISTER_LAZY_PLUGIN(Second);
+REGISTER_LAZY_PLUGIN(Broken);
+REGISTER_PLUGIN(Third);
+
+int main() {
+    using linktimeplugin::plugins;
+    using Registry = linktimeplugin::RegistrarBase<Item>;
+
+    // An empty view
+    const linktimeplugin::View<Item> none;
+    CHECK(none.empty() && none.size() == 0 && none.begin() == none.end());
+
+    // All registrars, without constructing anything
+    CHECK(Registry::registrars().size() == 4);
+    CHECK(lazies == 0);
+
+    // The first call constructs the lazy plug-ins and leaves out the
+    // one that can't be constructed; the order is that of registration
+    const auto all = plugins<Item>();
+    CHECK(lazies == 1);
+    CHECK(all.size() == 3);
+    if (all.size() == 3) {
+        CHECK(all[0]->number() == 1 && all[1]->number() == 2 && all[2]->number() == 3);
+    }
+    auto sum = 0;
+    for (const auto p : all) sum += p->number();
+    CHECK(sum == 6);
+
+    // Further calls return the same view
+    const auto again = plugins<Item>();
+    CHECK(again.begin() == all.begin() && again.size() == all.size());
+    CHECK(lazies == 1);
+
+    // A registration changes the registry and the view
+    const auto version = Registry::version();
+    std::unique_ptr<linktimeplugin::Registrar<Fourth>> fourth(new linktimeplugin::Registrar<Fourth>);
+    CHECK(Registry::version() != version);
+    const auto more = plugins<Item>();
+    CHECK(more.size() == 4);
+    if (more.size() == 4) CHECK(more[3]->number() == 4);
+
+    // So does an unregistration
+    fourth.reset();
+    CHECK(plugins<Item>().size() == 3);
+
+    // A failed plug-in is left out
+    for (const auto r : Registry::registrars()) {
+        if (r->get() && r->get()->number() == 3) r->fail();
+    }
+    const auto left = plugins<Item>();
+    CHECK(left.size() == 2);
+    for (const auto p : left) CHECK(p->number() != 3);
+
+    return test::result();
+}
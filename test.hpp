@@ -0,0 +1,46 @@
+/**
+ * @brief Link-time plug-in tests: Checks
+ * @author agent
+ * @date 2026-10-16
+ * @copyright MIT license
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+/**
+ * Minimal checks for the test programs. Unlike assert(), they're also
+ * evaluated in release builds, and a failed check doesn't stop the
+ * program, so one run reports all failures.
+ *
+ * Example:
+ *
+ *      int main() {
+ *          CHECK(linktimeplugin::plugins<Base>().size() == 3);
+ *          return test::result();
+ *      }
+ */
+namespace test {
+    // Returns the number of failed checks
+    inline int& failures() noexcept {
+        static int ret = 0;
+        return ret;
+    }
+
+    // Reports a failed check
+    inline void check(bool ok, const char* what, const char* file, int line) {
+        if (!ok) {
+            std::cerr << file << ':' << line << ": Check failed: " << what << '\n';
+            ++failures();
+        }
+    }
+
+    // Returns the exit code of the test program
+    inline int result() {
+        return failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
+
+#define CHECK(x) test::check((x), #x, __FILE__, __LINE__)